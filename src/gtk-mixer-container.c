@@ -27,108 +27,82 @@
 #include "gtk-mixer.h"
 
 
-static void
-gtk_mixer_container_destroy(GtkWidget *container __unused, gpointer user_data) {
-	GHashTable *widgets = user_data;
+#define GM_CONT_TABS		4
 
-	g_hash_table_remove_all(widgets);
-	g_hash_table_unref(widgets);
-}
+/* Line widgets indexed by device line index.
+ * Tabs contents is created on first show. */
+typedef struct gtk_mixer_container_s {
+	gmp_dev_p dev;
+	GtkWidget **lines;
+	size_t lines_count;
+	GtkWidget *tabs[GM_CONT_TABS]; /* NULL - no controls in tab. */
+	int tabs_built[GM_CONT_TABS];
+} gm_container_t, *gm_container_p;
 
-GtkWidget *
-gtk_mixer_container_create(void) {
-	GtkWidget *container;
-	GHashTable *widgets;
 
-	container = gtk_notebook_new();
-	gtk_notebook_set_show_border(GTK_NOTEBOOK(container), TRUE);
-	widgets = g_hash_table_new_full(g_str_hash,
-	    g_str_equal, g_free, NULL);
-	g_object_set_data(G_OBJECT(container),
-	    "__gtk_mixer_container_widgets", widgets);
-	g_signal_connect(container, "destroy",
-	    G_CALLBACK(gtk_mixer_container_destroy), widgets);
+/* Tab where line is shown. */
+static inline size_t
+gtk_mixer_container_line_tab(gmp_dev_line_p line) {
 
-	return (container);
+	return ((0 == line->is_capture) ? 0 : 1);
 }
 
 static void
-gtk_mixer_container_create_contents(GtkWidget *container,
-    GHashTable *widgets, gmp_dev_p dev) {
+gtk_mixer_container_tab_build(gm_container_p gm_cont, const size_t tab) {
+	gmp_dev_p dev = gm_cont->dev;
 	gmp_dev_line_p line;
-	const gchar *titles[4] = { N_("_Playback"), N_("C_apture"),
-		N_("S_witches"), N_("_Options") };
-	GtkWidget *line_widget, *line_label_widget;
-	GtkWidget *labels[4], *scrollwins[4], *views[4];
-	GtkWidget *last_separator[4] = { NULL, NULL, NULL, NULL };
-	GtkWidget *vbox, *label1, *label2, *label3;
+	GtkWidget *view, *line_widget, *line_label_widget;
+	GtkWidget *last_separator = NULL;
 	const char *line_label;
-	gint num_children[4] = { 0, 0, 0, 0 };
-	gboolean no_controls_visible = TRUE;
-	size_t idx;
+	gint num_children = 0;
 
-	/* Create widgets for all four tabs. */
-	for (size_t i = 0; i < 4; i ++) {
-		labels[i] = gtk_label_new_with_mnemonic(_(titles[i]));
-		scrollwins[i] = gtk_scrolled_window_new(NULL, NULL);
-		gtk_scrolled_window_set_shadow_type(
-		    GTK_SCROLLED_WINDOW(scrollwins[i]), GTK_SHADOW_IN);
-		gtk_container_set_border_width(GTK_CONTAINER(scrollwins[i]),
-		    BORDER_WIDTH);
-		gtk_scrolled_window_set_policy(
-		    GTK_SCROLLED_WINDOW(scrollwins[i]),
-		    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	if (NULL == gm_cont->tabs[tab] ||
+	    0 != gm_cont->tabs_built[tab])
+		return;
+	gm_cont->tabs_built[tab] = 1;
 
-		views[i] = gtk_grid_new();
-		g_object_set(G_OBJECT(views[i]),
-		    "row-spacing", BORDER_WIDTH,
-		    "column-spacing", (BORDER_WIDTH * 2),
-		    "border-width", BORDER_WIDTH, NULL);
-		gtk_container_add(GTK_CONTAINER(scrollwins[i]), views[i]);
-		gtk_viewport_set_shadow_type(GTK_VIEWPORT(
-		    gtk_bin_get_child(GTK_BIN(scrollwins[i]))),
-		    GTK_SHADOW_NONE);
-		gtk_widget_show(views[i]);
-		gtk_widget_show(scrollwins[i]);
-	}
+	view = gtk_grid_new();
+	g_object_set(G_OBJECT(view),
+	    "row-spacing", BORDER_WIDTH,
+	    "column-spacing", (BORDER_WIDTH * 2),
+	    "border-width", BORDER_WIDTH, NULL);
 
-	/* Create controls for all mixer lines. */
+	/* Create controls for tab mixer lines. */
 	//preferences = gtk_mixer_preferences_get();
-	for (size_t i = 0; NULL != dev && i < dev->lines_count; i ++) {
-		line = &dev->lines[i];
+	for (size_t i = 0; i < gm_cont->lines_count; i ++) {
+		line = gmp_dev_line_get(dev, i);
+		if (tab != gtk_mixer_container_line_tab(line))
+			continue;
 		line_label = line->display_name;
 
 		//if (!gtk_mixer_preferences_get_control_visible(
 		//	preferences, line_label))
 		//	continue;
 
-		idx = ((0 == line->is_capture) ? 0 : 1);
 		/* Create a regular volume control for this line. */
 		line_label_widget = gtk_label_new(line_label);
-		gtk_grid_attach(GTK_GRID(views[idx]),
-		    line_label_widget, num_children[idx], 0, 1, 1);
+		gtk_grid_attach(GTK_GRID(view),
+		    line_label_widget, num_children, 0, 1, 1);
 		gtk_widget_show(line_label_widget);
 		line_widget = gtk_mixer_line_create(dev, line);
 		g_object_set(G_OBJECT(line_widget),
 		    "valign", GTK_ALIGN_FILL,
 		    "vexpand", TRUE, NULL);
-		gtk_grid_attach(GTK_GRID(views[idx]),
-		    line_widget, num_children[idx], 1, 1, 1);
+		gtk_grid_attach(GTK_GRID(view),
+		    line_widget, num_children, 1, 1, 1);
 		gtk_widget_show(line_widget);
-		num_children[idx]++;
+		num_children ++;
 
 		/* Append a separator. The last one will be
 		 * destroyed later. */
-		last_separator[idx] = gtk_separator_new(
+		last_separator = gtk_separator_new(
 		    GTK_ORIENTATION_VERTICAL);
-		gtk_grid_attach(GTK_GRID(views[idx]),
-		    last_separator[idx], num_children[idx], 0, 1, 2);
-		gtk_widget_show(last_separator[idx]);
-		num_children[idx]++;
+		gtk_grid_attach(GTK_GRID(view),
+		    last_separator, num_children, 0, 1, 2);
+		gtk_widget_show(last_separator);
+		num_children ++;
 
-		/* Add the line to the hash table. */
-		g_hash_table_insert(widgets,
-		    g_strdup(line_label), line_widget);
+		gm_cont->lines[i] = line_widget;
 
 #if 0
 		case XFCE_MIXER_TRACK_TYPE_SWITCH:
@@ -176,25 +150,90 @@ gtk_mixer_container_create_contents(GtkWidget *container,
 			break;
 #endif
 	}
+	/* Destroy the last separator in the tab. */
+	if (NULL != last_separator) {
+		gtk_widget_destroy(last_separator);
+	}
+
+	gtk_container_add(GTK_CONTAINER(gm_cont->tabs[tab]), view);
+	gtk_viewport_set_shadow_type(GTK_VIEWPORT(
+	    gtk_bin_get_child(GTK_BIN(gm_cont->tabs[tab]))),
+	    GTK_SHADOW_NONE);
+	gtk_widget_show(view);
+}
 
-	/* Append tab or destroy all its widgets - depending on the
-	 * contents of each tab. */
-	for (gint i = 0; i < 4; i ++) {
-		/* Destroy the last separator in the tab. */
-		if (last_separator[i] != NULL) {
-			gtk_widget_destroy(last_separator[i]);
-		}
+static void
+gtk_mixer_container_switch_page(GtkNotebook *notebook __unused,
+    GtkWidget *page, guint page_num __unused, gpointer user_data) {
+	gm_container_p gm_cont = user_data;
+
+	for (size_t i = 0; i < GM_CONT_TABS; i ++) {
+		if (page != gm_cont->tabs[i])
+			continue;
+		gtk_mixer_container_tab_build(gm_cont, i);
+		break;
+	}
+}
+
+static void
+gtk_mixer_container_destroy(GtkWidget *container __unused, gpointer user_data) {
+	gm_container_p gm_cont = user_data;
+
+	free(gm_cont->lines);
+	free(gm_cont);
+}
 
+GtkWidget *
+gtk_mixer_container_create(void) {
+	GtkWidget *container;
+	gm_container_p gm_cont;
+
+	gm_cont = calloc(1, sizeof(gm_container_t));
+	if (NULL == gm_cont)
+		return (NULL);
+	container = gtk_notebook_new();
+	gtk_notebook_set_show_border(GTK_NOTEBOOK(container), TRUE);
+	g_object_set_data(G_OBJECT(container),
+	    "__gtk_mixer_container", gm_cont);
+	g_signal_connect(container, "switch-page",
+	    G_CALLBACK(gtk_mixer_container_switch_page), gm_cont);
+	g_signal_connect(container, "destroy",
+	    G_CALLBACK(gtk_mixer_container_destroy), gm_cont);
+
+	return (container);
+}
+
+static void
+gtk_mixer_container_create_contents(GtkWidget *container,
+    gm_container_p gm_cont) {
+	const gchar *titles[GM_CONT_TABS] = { N_("_Playback"),
+		N_("C_apture"), N_("S_witches"), N_("_Options") };
+	GtkWidget *label, *vbox, *label1, *label2, *label3;
+	size_t num_children[GM_CONT_TABS] = { 0, 0, 0, 0 };
+	gboolean no_controls_visible = TRUE;
+
+	for (size_t i = 0; i < gm_cont->lines_count; i ++) {
+		num_children[gtk_mixer_container_line_tab(
+		    gmp_dev_line_get(gm_cont->dev, i))] ++;
+	}
+
+	/* Only tabs with controls, contents created on first show. */
+	for (size_t i = 0; i < GM_CONT_TABS; i ++) {
+		if (0 == num_children[i])
+			continue;
+		no_controls_visible = FALSE;
+		label = gtk_label_new_with_mnemonic(_(titles[i]));
+		gm_cont->tabs[i] = gtk_scrolled_window_new(NULL, NULL);
+		gtk_scrolled_window_set_shadow_type(
+		    GTK_SCROLLED_WINDOW(gm_cont->tabs[i]), GTK_SHADOW_IN);
+		gtk_container_set_border_width(
+		    GTK_CONTAINER(gm_cont->tabs[i]), BORDER_WIDTH);
+		gtk_scrolled_window_set_policy(
+		    GTK_SCROLLED_WINDOW(gm_cont->tabs[i]),
+		    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+		gtk_widget_show(gm_cont->tabs[i]);
 		gtk_notebook_append_page(GTK_NOTEBOOK(container),
-		    scrollwins[i], labels[i]);
-
-		/* Hide tabs with no visible controls. */
-		if (num_children[i] > 0) {
-			no_controls_visible = FALSE;
-		} else {
-			gtk_widget_hide(gtk_notebook_get_nth_page(
-			    GTK_NOTEBOOK(container), i));
-		}
+		    gm_cont->tabs[i], label);
 	}
 	/* Show informational message if no controls are visible. */
 	if (no_controls_visible) {
@@ -238,41 +277,61 @@ gtk_mixer_container_create_contents(GtkWidget *container,
 void
 gtk_mixer_container_dev_set(GtkWidget *container, gmp_dev_p dev) {
 	gint current_tab, i;
-	GHashTable *widgets = g_object_get_data(G_OBJECT(container),
-	    "__gtk_mixer_container_widgets");
+	gm_container_p gm_cont = g_object_get_data(G_OBJECT(container),
+	    "__gtk_mixer_container");
 
-	g_hash_table_remove_all(widgets);
+	if (NULL == gm_cont)
+		return;
 
 	/* Remember active tab */
 	current_tab = gtk_notebook_get_current_page(GTK_NOTEBOOK(container));
 
 	/* Destroy all tabs */
+	memset(gm_cont->tabs, 0x00, sizeof(gm_cont->tabs));
+	memset(gm_cont->tabs_built, 0x00, sizeof(gm_cont->tabs_built));
 	for (i = gtk_notebook_get_n_pages(GTK_NOTEBOOK(container)); i >= 0; i --) {
 		gtk_notebook_remove_page(GTK_NOTEBOOK(container), i);
 	}
 
+	free(gm_cont->lines);
+	gm_cont->dev = dev;
+	gm_cont->lines_count = ((NULL != dev) ? dev->lines_count : 0);
+	gm_cont->lines = calloc((gm_cont->lines_count + 1),
+	    sizeof(GtkWidget*));
+	if (NULL == gm_cont->lines) {
+		gm_cont->lines_count = 0;
+	}
+
 	/* Re-create contents */
-	gtk_mixer_container_create_contents(container, widgets, dev);
+	gtk_mixer_container_create_contents(container, gm_cont);
 
 	/* Restore previously active tab if possible */
-	if (current_tab > 0 && current_tab < 4) {
+	if (current_tab > 0 && current_tab < GM_CONT_TABS) {
 		gtk_notebook_set_current_page(GTK_NOTEBOOK(container),
 		    current_tab);
 	}
+	/* First page may be shown without "switch-page". */
+	current_tab = gtk_notebook_get_current_page(GTK_NOTEBOOK(container));
+	gtk_mixer_container_switch_page(GTK_NOTEBOOK(container),
+	    gtk_notebook_get_nth_page(GTK_NOTEBOOK(container), current_tab),
+	    (guint)current_tab, gm_cont);
 }
 
 void
-gtk_mixer_container_update(GtkWidget *container) {
-	GtkWidget *line_widget;
-	GHashTable *widgets = g_object_get_data(G_OBJECT(container),
-	    "__gtk_mixer_container_widgets");
-	GHashTableIter iter;
+gtk_mixer_container_line_update(GtkWidget *container,
+    gmp_dev_line_p dev_line) {
+	size_t idx;
+	gm_container_p gm_cont;
 
-	if (NULL == container || NULL == widgets)
+	if (NULL == container || NULL == dev_line)
 		return;
-
-	g_hash_table_iter_init(&iter, widgets);
-	while (g_hash_table_iter_next(&iter, NULL, (void**)&line_widget)) {
-		gtk_mixer_line_update(line_widget);
-	}
+	gm_cont = g_object_get_data(G_OBJECT(container),
+	    "__gtk_mixer_container");
+	if (NULL == gm_cont)
+		return;
+	idx = gmp_dev_line_idx(dev_line);
+	if (gm_cont->lines_count <= idx ||
+	    NULL == gm_cont->lines[idx])
+		return;
+	gtk_mixer_line_update(gm_cont->lines[idx]);
 }
@@ -35,8 +35,6 @@ gtk_mixer_devs_combo_changed(GtkWidget *combo, gpointer user_data __unused) {
 	GtkListStore *list_store = g_object_get_data(G_OBJECT(combo),
 	    "__gtk_mixer_devs_combo_list_store");
 	gmp_dev_p dev_new = NULL;
-	gmp_dev_p dev_old = g_object_get_data(G_OBJECT(combo),
-	    "__gtk_mixer_devs_combo_current");
 
 	if (NULL == list_store)
 		return;
@@ -45,11 +43,10 @@ gtk_mixer_devs_combo_changed(GtkWidget *combo, gpointer user_data __unused) {
 		    GM_CMB_DEVS_COLUMN_CARD, &dev_new, -1);
 	}
 
-	/* Init/uninit here, before other get notification. */
-	gmp_dev_init(dev_new);
+	/* Set here, before other get notification.
+	 * Device init/uninit is done by window devices cache. */
 	g_object_set_data(G_OBJECT(combo),
 	    "__gtk_mixer_devs_combo_current", dev_new);
-	gmp_dev_uninit(dev_old);
 }
 
 static void
@@ -99,12 +96,30 @@ gtk_mixer_devs_combo_cur_get(GtkWidget *combo) {
 	    "__gtk_mixer_devs_combo_current"));
 }
 
+static gboolean
+gtk_mixer_devs_combo_iter_find(GtkListStore *list_store, gmp_dev_p dev,
+    GtkTreeIter *iter) {
+	gmp_dev_p device_cur = NULL;
+	gboolean valid_iter;
+
+	valid_iter = gtk_tree_model_get_iter_first(
+	    GTK_TREE_MODEL(list_store), iter);
+	while (valid_iter) {
+		gtk_tree_model_get(GTK_TREE_MODEL(list_store),
+		    iter, GM_CMB_DEVS_COLUMN_CARD, &device_cur, -1);
+		if (device_cur == dev)
+			return (TRUE);
+		valid_iter = gtk_tree_model_iter_next(
+		    GTK_TREE_MODEL(list_store), iter);
+	}
+
+	return (FALSE);
+}
+
 void
 gtk_mixer_devs_combo_cur_set(GtkWidget *combo,
     gmp_dev_p dev) {
-	gmp_dev_p device_cur = NULL;
 	GtkTreeIter iter;
-	gboolean valid_iter;
 	GtkListStore *list_store = g_object_get_data(G_OBJECT(combo),
 	    "__gtk_mixer_devs_combo_list_store");
 
@@ -112,18 +127,8 @@ gtk_mixer_devs_combo_cur_set(GtkWidget *combo,
 		gtk_combo_box_set_active(GTK_COMBO_BOX(combo), 0);
 		return;
 	}
-	valid_iter = gtk_tree_model_get_iter_first(
-	    GTK_TREE_MODEL(list_store), &iter);
-	while (valid_iter) {
-		gtk_tree_model_get(GTK_TREE_MODEL(list_store),
-		    &iter, GM_CMB_DEVS_COLUMN_CARD, &device_cur, -1);
-		if (device_cur == dev) {
-			gtk_combo_box_set_active_iter(GTK_COMBO_BOX(combo),
-			    &iter);
-			break;
-		}
-		valid_iter = gtk_tree_model_iter_next(
-		    GTK_TREE_MODEL(list_store), &iter);
+	if (gtk_mixer_devs_combo_iter_find(list_store, dev, &iter)) {
+		gtk_combo_box_set_active_iter(GTK_COMBO_BOX(combo), &iter);
 	}
 }
 
@@ -162,29 +167,55 @@ gtk_mixer_devs_combo_dev_descr(gmp_dev_p dev, char *buf, size_t buf_size) {
 }
 
 void
-gtk_mixer_devs_combo_dev_list_set(GtkWidget *combo, gmp_dev_list_p dev_list) {
-	gmp_dev_p dev = NULL;
+gtk_mixer_devs_combo_dev_add(GtkWidget *combo, gmp_dev_p dev,
+    const size_t pos) {
 	GtkTreeIter iter;
 	GtkListStore *list_store = g_object_get_data(G_OBJECT(combo),
 	    "__gtk_mixer_devs_combo_list_store");
 	char display_name[256];
 
-	if (NULL == list_store)
+	if (NULL == list_store || NULL == dev)
 		return;
 
-	gtk_list_store_clear(list_store);
-	if (NULL == dev_list)
+	gtk_mixer_devs_combo_dev_descr(dev,
+	    display_name, sizeof(display_name));
+	gtk_list_store_insert_with_values(list_store, &iter,
+	    (gint)MIN(pos, G_MAXINT),
+	    GM_CMB_DEVS_COLUMN_CARD, dev,
+	    GM_CMB_DEVS_COLUMN_NAME, display_name, -1);
+}
+
+void
+gtk_mixer_devs_combo_dev_remove(GtkWidget *combo, gmp_dev_p dev) {
+	GtkTreeIter iter;
+	GtkListStore *list_store = g_object_get_data(G_OBJECT(combo),
+	    "__gtk_mixer_devs_combo_list_store");
+
+	if (NULL == list_store || NULL == dev)
 		return;
-	for (size_t i = 0; i < dev_list->count; i ++) {
-		gtk_list_store_append(list_store, &iter);
-		dev = &dev_list->devs[i];
-		gtk_mixer_devs_combo_dev_descr(dev,
-		    display_name, sizeof(display_name));
-		gtk_list_store_set(list_store, &iter,
-		    GM_CMB_DEVS_COLUMN_CARD, dev,
-		    GM_CMB_DEVS_COLUMN_NAME, display_name, -1);
+	/* Emit "changed" if dev is current. */
+	if (gtk_mixer_devs_combo_iter_find(list_store, dev, &iter)) {
+		gtk_list_store_remove(list_store, &iter);
 	}
 }
+
+void
+gtk_mixer_devs_combo_dev_update(GtkWidget *combo, gmp_dev_p dev) {
+	GtkTreeIter iter;
+	GtkListStore *list_store = g_object_get_data(G_OBJECT(combo),
+	    "__gtk_mixer_devs_combo_list_store");
+	char display_name[256];
+
+	if (NULL == list_store || NULL == dev)
+		return;
+	if (!gtk_mixer_devs_combo_iter_find(list_store, dev, &iter))
+		return;
+	gtk_mixer_devs_combo_dev_descr(dev,
+	    display_name, sizeof(display_name));
+	gtk_list_store_set(list_store, &iter,
+	    GM_CMB_DEVS_COLUMN_NAME, display_name, -1);
+}
+
 void
 gtk_mixer_devs_combo_update(GtkWidget *combo) {
 	gmp_dev_p dev = NULL;
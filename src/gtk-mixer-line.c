@@ -27,374 +27,995 @@
 #include "gtk-mixer.h"
 
 
+#define GM_LINE_PART_NONE	0
+#define GM_LINE_PART_FADER	1
+#define GM_LINE_PART_SLIDER	2 /* Fader slider. */
+#define GM_LINE_PART_LOCK	3
+#define GM_LINE_PART_ENABLE	4
+
+#define GM_LINE_SCROLL_STEP	5
+#define GM_LINE_PAGE_STEP	10
+
+
+/* Style contexts for parts drawn by line strip, shared by all lines. */
+typedef struct gtk_mixer_line_style_s {
+	GtkStyleContext *scale;
+	GtkStyleContext *trough;
+	GtkStyleContext *highlight;
+	GtkStyleContext *slider;
+	GtkStyleContext *button;
+} gm_line_style_t;
+
+static gm_line_style_t gm_line_style;
+
+
+/* Icons shared by all lines: volume_stock_from_level() levels and lock
+ * states. Loaded on first use, reused on updates.
+ * Symbolic icons are colored by button state: it is part of key. */
+#define GM_LINE_ICONS_MAX	64
+
+typedef struct gtk_mixer_line_icon_s {
+	const char *name; /* Static string, compared by pointer. */
+	int size;
+	int scale;
+	GtkStateFlags state;
+	cairo_surface_t *surface;
+} gm_line_icon_t, *gm_line_icon_p;
+
+static gm_line_icon_t gm_line_icons[GM_LINE_ICONS_MAX];
+static size_t gm_line_icons_count;
+static size_t gm_line_icons_loads; /* Reported by app stats. */
+
+
+/* Line strip parts geometry, widget coordinates. */
+typedef struct gtk_mixer_line_geom_s {
+	int fader_w;	/* Scale width. */
+	int fader_min_h;
+	int fader_h;
+	int faders_x;	/* First fader column. */
+	int faders_w;	/* All faders with spacing. */
+	int slider_w;
+	int slider_h;
+	int button_w;
+	int button_h;
+	int icon_size;
+	GdkRectangle lock_row; /* Lock button and bracket arms. */
+	GdkRectangle lock;
+	GdkRectangle enable;
+} gm_line_geom_t, *gm_line_geom_p;
+
 typedef struct gtk_mixer_line_s {
 	gmp_dev_p dev;
 	gmp_dev_line_p dev_line;
-	GtkWidget *container;
-	GtkWidget *enable_button; /* Mute/record, depend on line type. */
-	GtkWidget *lock_button;
-	GList *channel_faders;
+	GtkWidget *widget;
 	const char *icon_name;
-	volatile gboolean ignore_signals;
+	uint64_t gen; /* dev_line->gen shown by widget. */
+	int is_locked;
+	int pressed; /* GM_LINE_PART_*, mouse button 1 hold on. */
+	int hover; /* GM_LINE_PART_*, under pointer. */
+	size_t hover_ch;
+	size_t drag_ch;
+	int drag_offset; /* Pointer offset from slider top. */
+	size_t focus_ch; /* Fader controlled by keyboard. */
+	gdouble scroll_delta; /* Smooth scroll remainder. */
 } gm_line_t, *gm_line_p;
 
 
+static void
+gtk_mixer_line_icons_clear(void) {
+
+	for (size_t i = 0; i < gm_line_icons_count; i ++) {
+		cairo_surface_destroy(gm_line_icons[i].surface);
+	}
+	memset(gm_line_icons, 0x00, sizeof(gm_line_icons));
+	gm_line_icons_count = 0;
+}
+
+static void
+gtk_mixer_line_icon_theme_changed(GtkIconTheme *icon_theme __unused,
+    gpointer user_data __unused) {
+
+	gtk_mixer_line_icons_clear();
+}
+
+static GtkStyleContext *
+gtk_mixer_line_style_node(GtkWidget *widget, GtkStyleContext *parent,
+    const char *name, const char *class1, const char *class2) {
+	GtkWidgetPath *path;
+	GtkStyleContext *ctx;
+
+	path = gtk_widget_path_copy(((NULL != parent) ?
+	    gtk_style_context_get_path(parent) :
+	    gtk_widget_get_path(widget)));
+	gtk_widget_path_append_type(path, G_TYPE_NONE);
+	gtk_widget_path_iter_set_object_name(path, -1, name);
+	if (NULL != class1) {
+		gtk_widget_path_iter_add_class(path, -1, class1);
+	}
+	if (NULL != class2) {
+		gtk_widget_path_iter_add_class(path, -1, class2);
+	}
+	ctx = gtk_style_context_new();
+	gtk_style_context_set_path(ctx, path);
+	gtk_style_context_set_parent(ctx, parent);
+	gtk_style_context_set_screen(ctx, gtk_widget_get_screen(widget));
+	gtk_widget_path_unref(path);
+
+	return (ctx);
+}
+
+static void
+gtk_mixer_line_style_init(GtkWidget *widget) {
+
+	if (NULL != gm_line_style.scale)
+		return;
+	/* Same nodes as GtkScale and GtkToggleButton have. */
+	gm_line_style.scale = gtk_mixer_line_style_node(widget, NULL,
+	    "scale", GTK_STYLE_CLASS_VERTICAL, NULL);
+	gm_line_style.trough = gtk_mixer_line_style_node(widget,
+	    gm_line_style.scale, "trough", NULL, NULL);
+	gm_line_style.highlight = gtk_mixer_line_style_node(widget,
+	    gm_line_style.trough, "highlight", GTK_STYLE_CLASS_BOTTOM, NULL);
+	gm_line_style.slider = gtk_mixer_line_style_node(widget,
+	    gm_line_style.trough, "slider", NULL, NULL);
+	gm_line_style.button = gtk_mixer_line_style_node(widget, NULL,
+	    "button", "toggle", "image-button");
+	g_signal_connect(gtk_icon_theme_get_for_screen(
+	    gtk_widget_get_screen(widget)), "changed",
+	    G_CALLBACK(gtk_mixer_line_icon_theme_changed), NULL);
+}
+
+/* Content min size to margin box size. */
+static void
+gtk_mixer_line_box_size(GtkStyleContext *ctx, int *width, int *height) {
+	GtkStateFlags state = gtk_style_context_get_state(ctx);
+	GtkBorder margin, border, padding;
+	int min_width = 0, min_height = 0;
+
+	gtk_style_context_get(ctx, state,
+	    "min-width", &min_width,
+	    "min-height", &min_height, NULL);
+	gtk_style_context_get_margin(ctx, state, &margin);
+	gtk_style_context_get_border(ctx, state, &border);
+	gtk_style_context_get_padding(ctx, state, &padding);
+	(*width) = (MAX((*width), min_width) +
+	    margin.left + margin.right +
+	    border.left + border.right +
+	    padding.left + padding.right);
+	(*height) = (MAX((*height), min_height) +
+	    margin.top + margin.bottom +
+	    border.top + border.bottom +
+	    padding.top + padding.bottom);
+}
+
+/* Margin box to border box. */
+static void
+gtk_mixer_line_box_border(GtkStyleContext *ctx, GdkRectangle *rect) {
+	GtkBorder margin;
+
+	gtk_style_context_get_margin(ctx,
+	    gtk_style_context_get_state(ctx), &margin);
+	rect->x += margin.left;
+	rect->y += margin.top;
+	rect->width -= (margin.left + margin.right);
+	rect->height -= (margin.top + margin.bottom);
+}
+
+/* Border box to content box. */
+static void
+gtk_mixer_line_box_content(GtkStyleContext *ctx, GdkRectangle *rect) {
+	GtkStateFlags state = gtk_style_context_get_state(ctx);
+	GtkBorder border, padding;
+
+	gtk_style_context_get_border(ctx, state, &border);
+	gtk_style_context_get_padding(ctx, state, &padding);
+	rect->x += (border.left + padding.left);
+	rect->y += (border.top + padding.top);
+	rect->width -= (border.left + border.right +
+	    padding.left + padding.right);
+	rect->height -= (border.top + border.bottom +
+	    padding.top + padding.bottom);
+}
+
+/* Draw node background and frame, rect: margin box in, content box out. */
+static void
+gtk_mixer_line_box_render(GtkStyleContext *ctx, cairo_t *cr,
+    GdkRectangle *rect) {
+
+	gtk_mixer_line_box_border(ctx, rect);
+	if (0 < rect->width && 0 < rect->height) {
+		gtk_render_background(ctx, cr, rect->x, rect->y,
+		    rect->width, rect->height);
+		gtk_render_frame(ctx, cr, rect->x, rect->y,
+		    rect->width, rect->height);
+	}
+	gtk_mixer_line_box_content(ctx, rect);
+}
+
+static void
+gtk_mixer_line_geom(gm_line_p line, gm_line_geom_p geom) {
+	const size_t faders_count = line->dev_line->chan_vol_count;
+	int width, height, lock_row_w, icon_h;
+
+	gtk_mixer_line_style_init(line->widget);
+
+	/* Slider and trough are inside scale. */
+	geom->slider_w = 0;
+	geom->slider_h = 0;
+	gtk_mixer_line_box_size(gm_line_style.slider,
+	    &geom->slider_w, &geom->slider_h);
+	width = geom->slider_w;
+	height = geom->slider_h;
+	gtk_mixer_line_box_size(gm_line_style.trough, &width, &height);
+	gtk_mixer_line_box_size(gm_line_style.scale, &width, &height);
+	geom->fader_w = width;
+	geom->fader_min_h = height;
+	/* Line without volume channels has no faders column. */
+	geom->faders_w = (int)((size_t)geom->fader_w * faders_count +
+	    (size_t)BORDER_WIDTH * (MAX(faders_count, 1) - 1));
+
+	if (!gtk_icon_size_lookup(GTK_ICON_SIZE_MENU, &geom->icon_size,
+	    &icon_h)) {
+		geom->icon_size = 16;
+	}
+	geom->button_w = geom->icon_size;
+	geom->button_h = geom->icon_size;
+	gtk_mixer_line_box_size(gm_line_style.button,
+	    &geom->button_w, &geom->button_h);
+
+	/* Place parts to allocation. */
+	width = gtk_widget_get_allocated_width(line->widget);
+	height = gtk_widget_get_allocated_height(line->widget);
+	geom->fader_h = MAX(geom->fader_min_h,
+	    (height - (2 * BORDER_WIDTH) - (2 * geom->button_h)));
+	geom->faders_x = ((width - geom->faders_w) / 2);
+	/* Bracket arms are at least BORDER_WIDTH * 2. */
+	lock_row_w = (geom->button_w + (4 * BORDER_WIDTH));
+	geom->lock_row.width = MAX(geom->faders_w, lock_row_w);
+	geom->lock_row.height = geom->button_h;
+	geom->lock_row.x = ((width - geom->lock_row.width) / 2);
+	geom->lock_row.y = (geom->fader_h + BORDER_WIDTH);
+	geom->lock.width = geom->button_w;
+	geom->lock.height = geom->button_h;
+	geom->lock.x = ((width - geom->button_w) / 2);
+	geom->lock.y = geom->lock_row.y;
+	geom->enable.width = geom->button_w;
+	geom->enable.height = geom->button_h;
+	geom->enable.x = geom->lock.x;
+	geom->enable.y = (geom->lock_row.y + geom->lock_row.height +
+	    BORDER_WIDTH);
+}
+
+/* Fader column parts: trough content box and slider margin box. */
+static void
+gtk_mixer_line_fader_geom(gm_line_p line, gm_line_geom_p geom,
+    const size_t ch_idx, GdkRectangle *scale, GdkRectangle *trough,
+    GdkRectangle *slider) {
+	size_t col = ch_idx;
+
+	if (GTK_TEXT_DIR_RTL == gtk_widget_get_direction(line->widget)) {
+		col = (line->dev_line->chan_vol_count - 1 - ch_idx);
+	}
+	scale->x = (geom->faders_x +
+	    (int)col * (geom->fader_w + BORDER_WIDTH));
+	scale->y = 0;
+	scale->width = geom->fader_w;
+	scale->height = geom->fader_h;
+	/* Trough take all scale content, slider move inside trough. */
+	(*trough) = (*scale);
+	gtk_mixer_line_box_border(gm_line_style.scale, trough);
+	gtk_mixer_line_box_content(gm_line_style.scale, trough);
+	gtk_mixer_line_box_border(gm_line_style.trough, trough);
+	gtk_mixer_line_box_content(gm_line_style.trough, trough);
+	slider->width = geom->slider_w;
+	slider->height = geom->slider_h;
+	slider->x = (trough->x + ((trough->width - slider->width) / 2));
+	slider->y = (trough->y + (((trough->height - slider->height) *
+	    (100 - line->dev_line->state.chan_vol[ch_idx])) / 100));
+}
+
+static int
+gtk_mixer_line_part_at(gm_line_p line, gm_line_geom_p geom,
+    const int x, const int y, size_t *ch_idx) {
+	GdkRectangle scale, trough, slider;
+
+	(*ch_idx) = 0;
+	if (x >= geom->enable.x && x < (geom->enable.x + geom->enable.width) &&
+	    y >= geom->enable.y && y < (geom->enable.y + geom->enable.height))
+		return (GM_LINE_PART_ENABLE);
+	if (1 < line->dev_line->chan_vol_count &&
+	    x >= geom->lock.x && x < (geom->lock.x + geom->lock.width) &&
+	    y >= geom->lock.y && y < (geom->lock.y + geom->lock.height))
+		return (GM_LINE_PART_LOCK);
+	for (size_t i = 0; i < line->dev_line->chan_vol_count; i ++) {
+		gtk_mixer_line_fader_geom(line, geom, i, &scale, &trough,
+		    &slider);
+		if (x < scale.x || x >= (scale.x + scale.width) ||
+		    y < scale.y || y >= (scale.y + scale.height))
+			continue;
+		(*ch_idx) = i;
+		/* Slider may be drawn outside of its margin box. */
+		gtk_mixer_line_box_border(gm_line_style.slider, &slider);
+		if (y >= slider.y && y < (slider.y + slider.height))
+			return (GM_LINE_PART_SLIDER);
+		return (GM_LINE_PART_FADER);
+	}
+
+	return (GM_LINE_PART_NONE);
+}
+
+
+static void
+gtk_mixer_line_write(gm_line_p line, const int flush) {
+	GtkWidget *window = gtk_widget_get_toplevel(line->widget);
+
+	gtk_mixer_window_dev_write(window, line->dev);
+	if (0 != flush) {
+		gtk_mixer_window_dev_write_flush(window);
+	}
+}
+
 static void
 gtk_mixer_line_icon_update(gm_line_p line) {
 	const char *stock;
 
-	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(line->enable_button),
-	    line->dev_line->state.is_enabled);
-
 	stock = volume_stock_from_level(line->dev_line->is_capture,
 	    line->dev_line->state.is_enabled,
 	    gmp_dev_line_vol_max_get(line->dev_line),
 	    line->icon_name);
-	if (NULL != stock) { /* Update icon. */
+	if (NULL != stock) { /* Icon will be loaded on draw. */
 		line->icon_name = stock;
-		gtk_button_set_image(GTK_BUTTON(line->enable_button),
-		    gtk_image_new_from_icon_name(stock, GTK_ICON_SIZE_MENU));
 	}
 }
 
-static void
-gtk_mixer_line_enable_toggled(GtkToggleButton *button, gpointer user_data) {
-	gm_line_p line = user_data;
+/* ctx state must be set to state. */
+static cairo_surface_t *
+gtk_mixer_line_icon_get(GtkWidget *widget, GtkStyleContext *ctx,
+    const GtkStateFlags state, const int size, const char *name) {
+	const int scale = gtk_widget_get_scale_factor(widget);
+	gm_line_icon_p icon;
+	GtkIconInfo *info;
+	GdkPixbuf *pixbuf;
+	cairo_surface_t *surface = NULL;
+
+	for (size_t i = 0; i < gm_line_icons_count; i ++) {
+		icon = &gm_line_icons[i];
+		if (name == icon->name &&
+		    size == icon->size &&
+		    scale == icon->scale &&
+		    state == icon->state)
+			return (icon->surface);
+	}
 
-	if (!line->ignore_signals) {
-		line->dev_line->state.is_enabled =
-		    (gtk_toggle_button_get_active(button) ? 1 : 0);
-		line->dev_line->is_updated = -1;
-		line->dev_line->write_required ++;
-		gmp_dev_write(line->dev, 0);
+	info = gtk_icon_theme_lookup_icon_for_scale(
+	    gtk_icon_theme_get_for_screen(gtk_widget_get_screen(widget)),
+	    name, size, scale, GTK_ICON_LOOKUP_FORCE_SIZE);
+	if (NULL != info) {
+		/* Symbolic icons colored as button label. */
+		pixbuf = gtk_icon_info_load_symbolic_for_context(info,
+		    ctx, NULL, NULL);
+		g_object_unref(info);
+		if (NULL != pixbuf) {
+			surface = gdk_cairo_surface_create_from_pixbuf(pixbuf,
+			    scale, gtk_widget_get_window(widget));
+			g_object_unref(pixbuf);
+		}
 	}
-	gtk_mixer_line_icon_update(line);
+	/* Failed load is also cached: do not retry on each draw. */
+	if (GM_LINE_ICONS_MAX <= gm_line_icons_count) {
+		gtk_mixer_line_icons_clear();
+	}
+	icon = &gm_line_icons[gm_line_icons_count ++];
+	icon->name = name;
+	icon->size = size;
+	icon->scale = scale;
+	icon->state = state;
+	icon->surface = surface;
+	gm_line_icons_loads ++;
+
+	return (surface);
 }
 
+static void
+gtk_mixer_line_button_render(gm_line_p line, cairo_t *cr,
+    gm_line_geom_p geom, const int part, const int is_active,
+    const char *icon_name) {
+	GtkStyleContext *ctx = gm_line_style.button;
+	cairo_surface_t *icon;
+	GtkStateFlags state = GTK_STATE_FLAG_NORMAL;
+	GdkRectangle rect = ((GM_LINE_PART_LOCK == part) ?
+	    geom->lock : geom->enable);
+
+	if (0 != line->dev_line->is_read_only) {
+		state |= GTK_STATE_FLAG_INSENSITIVE;
+	} else {
+		if (part == line->hover) {
+			state |= GTK_STATE_FLAG_PRELIGHT;
+		}
+		if (part == line->pressed && part == line->hover) {
+			state |= GTK_STATE_FLAG_ACTIVE;
+		}
+	}
+	if (0 != is_active) {
+		state |= GTK_STATE_FLAG_CHECKED;
+	}
+
+	gtk_style_context_save(ctx);
+	gtk_style_context_set_state(ctx, state);
+	gtk_mixer_line_box_render(ctx, cr, &rect);
+	icon = gtk_mixer_line_icon_get(line->widget, ctx, state,
+	    geom->icon_size, icon_name);
+	if (NULL != icon) {
+		gtk_render_icon_surface(ctx, cr, icon,
+		    (rect.x + ((rect.width - geom->icon_size) / 2)),
+		    (rect.y + ((rect.height - geom->icon_size) / 2)));
+	}
+	gtk_style_context_restore(ctx);
+}
 
 static void
-gtk_mixer_line_vol_glob_set(gm_line_p line, gdouble vol_new) {
-	GList *iter;
+gtk_mixer_line_fader_render(gm_line_p line, cairo_t *cr,
+    gm_line_geom_p geom, const size_t ch_idx) {
+	GtkStateFlags state = GTK_STATE_FLAG_NORMAL, slider_state;
+	GdkRectangle scale, trough, slider, rect;
 
-	/* Disable gtk_mixer_line_fader_changed(). */
-	line->ignore_signals = TRUE;
-	/* Apply vol_new to all faders. */
-	for (iter = line->channel_faders; iter != NULL; iter = g_list_next(iter)) {
-		/* Apply the volume of the first fader to the others. */
-		gtk_range_set_value(GTK_RANGE(iter->data), vol_new);
+	if (0 != line->dev_line->is_read_only) {
+		state |= GTK_STATE_FLAG_INSENSITIVE;
+	}
+	slider_state = state;
+	if (0 == line->dev_line->is_read_only) {
+		if (GM_LINE_PART_SLIDER == line->hover &&
+		    ch_idx == line->hover_ch) {
+			slider_state |= GTK_STATE_FLAG_PRELIGHT;
+		}
+		if (GM_LINE_PART_SLIDER == line->pressed &&
+		    ch_idx == line->drag_ch) {
+			slider_state |= (GTK_STATE_FLAG_PRELIGHT |
+			    GTK_STATE_FLAG_ACTIVE);
+		}
 	}
-	line->ignore_signals = FALSE;
 
-	/* Update volume. */
-	gmp_dev_line_vol_glob_set(line->dev_line, (int)vol_new);
-	line->dev_line->is_updated = -1;
-	line->dev_line->write_required ++;
-	gmp_dev_write(line->dev, 0);
+	gtk_style_context_save(gm_line_style.scale);
+	gtk_style_context_save(gm_line_style.trough);
+	gtk_style_context_save(gm_line_style.highlight);
+	gtk_style_context_save(gm_line_style.slider);
+	gtk_style_context_set_state(gm_line_style.scale, state);
+	gtk_style_context_set_state(gm_line_style.trough, state);
+	gtk_style_context_set_state(gm_line_style.highlight, state);
+	gtk_style_context_set_state(gm_line_style.slider, slider_state);
+
+	gtk_mixer_line_fader_geom(line, geom, ch_idx, &scale, &trough,
+	    &slider);
+	rect = scale;
+	gtk_mixer_line_box_render(gm_line_style.scale, cr, &rect);
+	gtk_mixer_line_box_render(gm_line_style.trough, cr, &rect);
+	/* Inverted: highlight from slider center to trough bottom. */
+	rect.y = (slider.y + (slider.height / 2));
+	rect.height = ((trough.y + trough.height) - rect.y);
+	gtk_mixer_line_box_render(gm_line_style.highlight, cr, &rect);
+	rect = slider;
+	gtk_mixer_line_box_render(gm_line_style.slider, cr, &rect);
+	if (ch_idx == line->focus_ch &&
+	    gtk_widget_has_visible_focus(line->widget)) {
+		rect = scale;
+		gtk_mixer_line_box_border(gm_line_style.scale, &rect);
+		gtk_render_focus(gm_line_style.scale, cr, rect.x, rect.y,
+		    rect.width, rect.height);
+	}
+
+	gtk_style_context_restore(gm_line_style.slider);
+	gtk_style_context_restore(gm_line_style.highlight);
+	gtk_style_context_restore(gm_line_style.trough);
+	gtk_style_context_restore(gm_line_style.scale);
 }
 
 static void
-gtk_mixer_line_fader_changed(GtkRange *range, gpointer user_data) {
+gtk_mixer_line_bracket_render(gm_line_p line, cairo_t *cr,
+    gm_line_geom_p geom) {
+	GtkStyleContext *style_context = gtk_widget_get_style_context(
+	    line->widget);
+	const int line_width = 2;
+	int left, right, y;
+	GdkRGBA fg_color;
+
+	/* Draw L-shaped lines from the lock button center to the top
+	 * middle of the arms. */
+	gtk_style_context_get_color(style_context, GTK_STATE_FLAG_NORMAL,
+	    &fg_color);
+	gdk_cairo_set_source_rgba(cr, &fg_color);
+	cairo_set_line_width(cr, line_width);
+	y = (geom->lock_row.y + ((geom->lock_row.height - line_width) / 2));
+	/* Left arm: from row start to lock button. */
+	left = (geom->lock_row.x +
+	    ((geom->lock.x - geom->lock_row.x + line_width) / 2));
+	cairo_move_to(cr, geom->lock.x, y);
+	cairo_line_to(cr, left, y);
+	cairo_line_to(cr, left, geom->lock_row.y);
+	/* Right arm: from lock button to row end. */
+	right = (geom->lock.x + geom->lock.width +
+	    ((geom->lock_row.x + geom->lock_row.width -
+	    geom->lock.x - geom->lock.width - line_width) / 2));
+	cairo_move_to(cr, (geom->lock.x + geom->lock.width), y);
+	cairo_line_to(cr, right, y);
+	cairo_line_to(cr, right, geom->lock_row.y);
+	cairo_stroke(cr);
+}
+
+static gboolean
+gtk_mixer_line_draw(GtkWidget *widget __unused, cairo_t *cr,
+    gpointer user_data) {
 	gm_line_p line = user_data;
-	size_t ch_idx;
-	gdouble vol_new = gtk_range_get_value(range);
-	char tooltip_text[256];
+	gm_line_geom_t geom;
 
-	ch_idx = (size_t)g_object_get_data(G_OBJECT(range),
-	    "__gtk_mixer_line_ch_idx");
-	/* Do almost nothing if signals are to be ignored. */
-	if (line->ignore_signals) {
-update_tooltip:
-		/* Update tooltip. */
-		snprintf(tooltip_text, sizeof(tooltip_text),
-		    "%s@%s: %i%%",
-		    channel_name_long[ch_idx], line->dev_line->display_name,
-		    (int)vol_new);
-		gtk_widget_set_tooltip_text(GTK_WIDGET(range), tooltip_text);
-		return;
-	}
+	gtk_mixer_line_geom(line, &geom);
 
-	/* Collect volumes of all channels. */
-	if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(line->lock_button))) {
-		gtk_mixer_line_vol_glob_set(line, vol_new);
-	} else { /* Single channel vol update. */
-		line->dev_line->state.chan_vol[ch_idx] = (int)vol_new;
-		/* Update volume. */
-		line->dev_line->is_updated = -1;
-		line->dev_line->write_required ++;
-		/* Commit changes to mixer dev. */
-		gmp_dev_write(line->dev, 0);
+	for (size_t i = 0; i < line->dev_line->chan_vol_count; i ++) {
+		gtk_mixer_line_fader_render(line, cr, &geom, i);
 	}
+	/* Lock button with lines only for multichannel lines, space
+	 * reserved anyway. */
+	if (1 < line->dev_line->chan_vol_count) {
+		gtk_mixer_line_bracket_render(line, cr, &geom);
+		gtk_mixer_line_button_render(line, cr, &geom,
+		    GM_LINE_PART_LOCK, line->is_locked,
+		    ((0 != line->is_locked) ?
+		    "emblem-readonly" : "emblem-shared"));
+	}
+	gtk_mixer_line_button_render(line, cr, &geom, GM_LINE_PART_ENABLE,
+	    line->dev_line->state.is_enabled, line->icon_name);
 
-	gtk_mixer_line_icon_update(line);
+	return (TRUE);
+}
 
-	goto update_tooltip;
+static void
+gtk_mixer_line_size_update(gm_line_p line) {
+	gm_line_geom_t geom;
+
+	gtk_mixer_line_geom(line, &geom);
+	gtk_widget_set_size_request(line->widget,
+	    MAX(geom.faders_w, geom.lock_row.width),
+	    (geom.fader_min_h + (2 * BORDER_WIDTH) + (2 * geom.button_h)));
 }
 
 static void
-gtk_mixer_line_lock_toggled(GtkToggleButton *button, gpointer user_data) {
+gtk_mixer_line_style_updated(GtkWidget *widget __unused,
+    gpointer user_data) {
 	gm_line_p line = user_data;
-	GtkWidget *image;
 
-	/* Do nothing if the channels were unlocked */
-	if (!gtk_toggle_button_get_active(button)) {
-		image = gtk_image_new_from_icon_name("emblem-shared",
-		    GTK_ICON_SIZE_MENU);
-		gtk_button_set_image(GTK_BUTTON(button), image);
+	/* Theme changed: parts size may change too. */
+	gtk_mixer_line_size_update(line);
+}
+
+static void
+gtk_mixer_line_vol_set(gm_line_p line, const size_t ch_idx, int vol) {
+
+	vol = CLAMP(vol, 0, 100);
+	if (vol == line->dev_line->state.chan_vol[ch_idx])
 		return;
+	if (0 != line->is_locked) {
+		gmp_dev_line_vol_glob_set(line->dev_line, vol);
+	} else { /* Single channel vol update. */
+		line->dev_line->state.chan_vol[ch_idx] = vol;
 	}
+	gmp_dev_line_changed(line->dev_line, 1);
+	line->gen = line->dev_line->gen;
+	/* Commit changes to mixer dev on next frame. */
+	gtk_mixer_line_write(line, 0);
+	gtk_mixer_line_icon_update(line);
+	gtk_widget_queue_draw(line->widget);
+}
+
+static void
+gtk_mixer_line_vol_set_at(gm_line_p line, const int y) {
+	gm_line_geom_t geom;
+	GdkRectangle scale, trough, slider;
+	int travel;
+
+	gtk_mixer_line_geom(line, &geom);
+	gtk_mixer_line_fader_geom(line, &geom, line->drag_ch, &scale,
+	    &trough, &slider);
+	travel = (trough.height - slider.height);
+	if (0 >= travel)
+		return;
+	gtk_mixer_line_vol_set(line, line->drag_ch,
+	    (100 - ((((y - line->drag_offset) - trough.y) * 100 +
+	    (travel / 2)) / travel)));
+}
 
-	image = gtk_image_new_from_icon_name("emblem-readonly",
-	    GTK_ICON_SIZE_MENU);
-	gtk_button_set_image(GTK_BUTTON(button), image);
+static void
+gtk_mixer_line_enable_toggle(gm_line_p line) {
+
+	line->dev_line->state.is_enabled =
+	    ((0 != line->dev_line->state.is_enabled) ? 0 : 1);
+	gmp_dev_line_changed(line->dev_line, 1);
+	line->gen = line->dev_line->gen;
+	gtk_mixer_line_write(line, 1);
+	gtk_mixer_line_icon_update(line);
+	gtk_widget_queue_draw(line->widget);
+}
+
+static void
+gtk_mixer_line_lock_toggle(gm_line_p line) {
 
+	line->is_locked = ((0 != line->is_locked) ? 0 : 1);
+	gtk_widget_queue_draw(line->widget);
 	/* Apply first fader volume to all faders. */
-	if (NULL != line->channel_faders &&
-	    NULL != line->channel_faders->data &&
-	    !line->ignore_signals) {
-		gtk_mixer_line_vol_glob_set(line,
-		    gtk_range_get_value(GTK_RANGE(line->channel_faders->data)));
+	if (0 == line->is_locked)
+		return;
+	gmp_dev_line_vol_glob_set(line->dev_line,
+	    line->dev_line->state.chan_vol[0]);
+	gmp_dev_line_changed(line->dev_line, 1);
+	line->gen = line->dev_line->gen;
+	gtk_mixer_line_write(line, 0);
+	gtk_mixer_line_icon_update(line);
+}
+
+static gboolean
+gtk_mixer_line_button_press(GtkWidget *widget, GdkEventButton *event,
+    gpointer user_data) {
+	gm_line_p line = user_data;
+	gm_line_geom_t geom;
+	GdkRectangle scale, trough, slider;
+	size_t ch_idx;
+	int part;
+
+	if (1 != event->button ||
+	    0 != line->dev_line->is_read_only)
+		return (FALSE);
+	if (GDK_BUTTON_PRESS != event->type)
+		return (TRUE); /* Ignore double and triple clicks. */
+
+	gtk_mixer_line_geom(line, &geom);
+	part = gtk_mixer_line_part_at(line, &geom, (int)event->x,
+	    (int)event->y, &ch_idx);
+	if (GM_LINE_PART_NONE == part)
+		return (FALSE);
+	line->pressed = part;
+	line->hover = part;
+	line->hover_ch = ch_idx;
+	switch (part) {
+	case GM_LINE_PART_FADER:
+	case GM_LINE_PART_SLIDER:
+		gtk_widget_grab_focus(widget);
+		line->focus_ch = ch_idx;
+		line->drag_ch = ch_idx;
+		gtk_mixer_line_fader_geom(line, &geom, ch_idx, &scale,
+		    &trough, &slider);
+		if (GM_LINE_PART_SLIDER == part) {
+			/* Keep pointer position on slider. */
+			line->drag_offset = ((int)event->y - slider.y);
+		} else { /* Warp slider center to pointer. */
+			line->pressed = GM_LINE_PART_SLIDER;
+			line->drag_offset = (slider.height / 2);
+			gtk_mixer_line_vol_set_at(line, (int)event->y);
+		}
+		break;
 	}
+	gtk_widget_queue_draw(widget);
+
+	return (TRUE);
 }
 
 static gboolean
-gtk_mixer_line_lock_button_line_draw(GtkWidget *widget, cairo_t *cr,
+gtk_mixer_line_button_release(GtkWidget *widget, GdkEventButton *event,
     gpointer user_data) {
-	GtkPositionType position = (GtkPositionType)(size_t)user_data;
-	GtkAllocation allocation;
-	GtkStyleContext *style_context = gtk_widget_get_style_context(widget);
-	GdkPoint points[3];
-	const int line_width = 2;
-	GdkRGBA fg_color;
+	gm_line_p line = user_data;
+	gm_line_geom_t geom;
+	size_t ch_idx;
+	int part, pressed = line->pressed;
+
+	if (1 != event->button ||
+	    GM_LINE_PART_NONE == pressed)
+		return (FALSE);
+	line->pressed = GM_LINE_PART_NONE;
+	gtk_widget_queue_draw(widget);
+
+	switch (pressed) {
+	case GM_LINE_PART_SLIDER:
+		/* Drag end: write last value now. */
+		gtk_mixer_window_dev_write_flush(
+		    gtk_widget_get_toplevel(widget));
+		break;
+	case GM_LINE_PART_LOCK:
+	case GM_LINE_PART_ENABLE:
+		gtk_mixer_line_geom(line, &geom);
+		part = gtk_mixer_line_part_at(line, &geom, (int)event->x,
+		    (int)event->y, &ch_idx);
+		if (part != pressed)
+			break; /* Released outside of button. */
+		if (GM_LINE_PART_LOCK == part) {
+			gtk_mixer_line_lock_toggle(line);
+		} else {
+			gtk_mixer_line_enable_toggle(line);
+		}
+		break;
+	}
+
+	return (TRUE);
+}
+
+static gboolean
+gtk_mixer_line_motion(GtkWidget *widget, GdkEventMotion *event,
+    gpointer user_data) {
+	gm_line_p line = user_data;
+	gm_line_geom_t geom;
+	size_t ch_idx;
+	int part;
+
+	if (GM_LINE_PART_SLIDER == line->pressed) {
+		gtk_mixer_line_vol_set_at(line, (int)event->y);
+		return (TRUE);
+	}
+	/* Prelight part under pointer. */
+	gtk_mixer_line_geom(line, &geom);
+	part = gtk_mixer_line_part_at(line, &geom, (int)event->x,
+	    (int)event->y, &ch_idx);
+	if (part != line->hover || ch_idx != line->hover_ch) {
+		line->hover = part;
+		line->hover_ch = ch_idx;
+		gtk_widget_queue_draw(widget);
+	}
+
+	return (FALSE);
+}
 
-	gtk_widget_get_allocation(widget, &allocation);
-	if (gtk_widget_get_direction(widget) == GTK_TEXT_DIR_RTL) {
-		position = (position == GTK_POS_LEFT) ? GTK_POS_RIGHT :
-							GTK_POS_LEFT;
+static gboolean
+gtk_mixer_line_leave(GtkWidget *widget, GdkEventCrossing *event __unused,
+    gpointer user_data) {
+	gm_line_p line = user_data;
+
+	if (GM_LINE_PART_NONE != line->hover) {
+		line->hover = GM_LINE_PART_NONE;
+		gtk_widget_queue_draw(widget);
 	}
 
-	/* Draw an L-shaped line from the right/left center to the top
-	 * middle of the allocation. */
-	gtk_style_context_get_color(style_context, GTK_STATE_FLAG_NORMAL,
-	    &fg_color);
-	gdk_cairo_set_source_rgba(cr, &fg_color);
-	cairo_set_line_width(cr, line_width);
-	if (position == GTK_POS_RIGHT) {
-		points[0].x = 0;
-		points[0].y = ((allocation.height - line_width) / 2);
-		points[1].x = ((allocation.width - line_width) / 2);
-		points[1].y = points[0].y;
-		points[2].x = points[1].x;
-		points[2].y = 0;
+	return (FALSE);
+}
+
+static gboolean
+gtk_mixer_line_scroll(GtkWidget *widget __unused, GdkEventScroll *event,
+    gpointer user_data) {
+	gm_line_p line = user_data;
+	gm_line_geom_t geom;
+	size_t ch_idx;
+	int part, vol_add;
+
+	if (0 != line->dev_line->is_read_only)
+		return (FALSE);
+	gtk_mixer_line_geom(line, &geom);
+	part = gtk_mixer_line_part_at(line, &geom, (int)event->x,
+	    (int)event->y, &ch_idx);
+	if (GM_LINE_PART_FADER != part &&
+	    GM_LINE_PART_SLIDER != part)
+		return (FALSE); /* Let scrolled window handle it. */
+
+	switch (event->direction) {
+	case GDK_SCROLL_UP:
+		vol_add = GM_LINE_SCROLL_STEP;
+		break;
+	case GDK_SCROLL_DOWN:
+		vol_add = -GM_LINE_SCROLL_STEP;
+		break;
+	case GDK_SCROLL_SMOOTH:
+		line->scroll_delta -= (event->delta_y * GM_LINE_SCROLL_STEP);
+		vol_add = (int)line->scroll_delta;
+		line->scroll_delta -= vol_add;
+		break;
+	default:
+		return (TRUE);
+	}
+	gtk_mixer_line_vol_set(line, ch_idx,
+	    (line->dev_line->state.chan_vol[ch_idx] + vol_add));
+
+	return (TRUE);
+}
+
+static gboolean
+gtk_mixer_line_key_press(GtkWidget *widget, GdkEventKey *event,
+    gpointer user_data) {
+	gm_line_p line = user_data;
+	int vol = line->dev_line->state.chan_vol[line->focus_ch];
+	int ch_move = 0;
+
+	if (0 != line->dev_line->is_read_only)
+		return (FALSE);
+
+	switch (event->keyval) {
+	case GDK_KEY_Up:
+	case GDK_KEY_KP_Up:
+		vol ++;
+		break;
+	case GDK_KEY_Down:
+	case GDK_KEY_KP_Down:
+		vol --;
+		break;
+	case GDK_KEY_Page_Up:
+	case GDK_KEY_KP_Page_Up:
+		vol += GM_LINE_PAGE_STEP;
+		break;
+	case GDK_KEY_Page_Down:
+	case GDK_KEY_KP_Page_Down:
+		vol -= GM_LINE_PAGE_STEP;
+		break;
+	case GDK_KEY_Home:
+	case GDK_KEY_KP_Home:
+		vol = 0;
+		break;
+	case GDK_KEY_End:
+	case GDK_KEY_KP_End:
+		vol = 100;
+		break;
+	case GDK_KEY_Left:
+	case GDK_KEY_KP_Left:
+		ch_move = -1;
+		break;
+	case GDK_KEY_Right:
+	case GDK_KEY_KP_Right:
+		ch_move = 1;
+		break;
+	case GDK_KEY_space:
+	case GDK_KEY_KP_Space:
+	case GDK_KEY_Return:
+	case GDK_KEY_KP_Enter:
+		gtk_mixer_line_enable_toggle(line);
+		return (TRUE);
+	default:
+		return (FALSE);
+	}
+
+	if (0 != ch_move) { /* Move keyboard focus to next fader. */
+		if (GTK_TEXT_DIR_RTL == gtk_widget_get_direction(widget)) {
+			ch_move = -ch_move;
+		}
+		if ((0 > ch_move && 0 == line->focus_ch) ||
+		    (0 < ch_move &&
+		     (line->focus_ch + 1) >= line->dev_line->chan_vol_count))
+			return (FALSE); /* Let focus leave widget. */
+		line->focus_ch = (size_t)((ssize_t)line->focus_ch + ch_move);
+		gtk_widget_queue_draw(widget);
+		return (TRUE);
+	}
+	gtk_mixer_line_vol_set(line, line->focus_ch, vol);
+	gtk_mixer_window_dev_write_flush(gtk_widget_get_toplevel(widget));
+
+	return (TRUE);
+}
+
+static gboolean
+gtk_mixer_line_query_tooltip(GtkWidget *widget __unused, gint x, gint y,
+    gboolean keyboard_mode, GtkTooltip *tooltip, gpointer user_data) {
+	gm_line_p line = user_data;
+	gm_line_geom_t geom;
+	GdkRectangle scale, trough, slider;
+	size_t ch_idx, ch_pos, i;
+	int part;
+	char tooltip_text[256];
+
+	gtk_mixer_line_geom(line, &geom);
+	if (keyboard_mode) {
+		part = GM_LINE_PART_FADER;
+		ch_idx = line->focus_ch;
 	} else {
-		points[0].x = allocation.width;
-		points[0].y = ((allocation.height - line_width) / 2);
-		points[1].x = ((allocation.width + line_width) / 2);
-		points[1].y = points[0].y;
-		points[2].x = points[1].x;
-		points[2].y = 0;
-	}
-	cairo_move_to(cr, points[0].x, points[0].y);
-	cairo_line_to(cr, points[1].x, points[1].y);
-	cairo_line_to(cr, points[2].x, points[2].y);
-	cairo_stroke(cr);
+		part = gtk_mixer_line_part_at(line, &geom, x, y, &ch_idx);
+	}
+
+	switch (part) {
+	case GM_LINE_PART_FADER:
+	case GM_LINE_PART_SLIDER:
+		for (ch_pos = gmp_dev_line_chan_first(line->dev_line), i = 0;
+		    ch_pos < MIXER_CHANNELS_COUNT && i < ch_idx;
+		    ch_pos = gmp_dev_line_chan_next(line->dev_line, ch_pos),
+		    i ++)
+			;
+		if (MIXER_CHANNELS_COUNT <= ch_pos)
+			return (FALSE);
+		snprintf(tooltip_text, sizeof(tooltip_text),
+		    "%s@%s: %i%%",
+		    channel_name_long[ch_pos], line->dev_line->display_name,
+		    line->dev_line->state.chan_vol[ch_idx]);
+		gtk_mixer_line_fader_geom(line, &geom, ch_idx, &scale,
+		    &trough, &slider);
+		gtk_tooltip_set_tip_area(tooltip, &scale);
+		break;
+	case GM_LINE_PART_LOCK:
+		snprintf(tooltip_text, sizeof(tooltip_text),
+		    _("Lock channels for %s together"),
+		    line->dev_line->display_name);
+		gtk_tooltip_set_tip_area(tooltip, &geom.lock);
+		break;
+	case GM_LINE_PART_ENABLE:
+		snprintf(tooltip_text, sizeof(tooltip_text),
+		    _("Enable/disable line %s"),
+		    line->dev_line->display_name);
+		gtk_tooltip_set_tip_area(tooltip, &geom.enable);
+		break;
+	default:
+		return (FALSE);
+	}
+	gtk_tooltip_set_text(tooltip, tooltip_text);
 
 	return (TRUE);
 }
 
 static void
-gtk_mixer_line_destroy(GtkWidget *container __unused, gpointer user_data) {
+gtk_mixer_line_destroy(GtkWidget *widget __unused, gpointer user_data) {
 	gm_line_p line = user_data;
 
-	g_list_free(line->channel_faders);
 	free(line);
 }
 
 GtkWidget *
 gtk_mixer_line_create(gmp_dev_p dev, gmp_dev_line_p dev_line) {
 	gm_line_p line;
-	size_t ch_idx;
-	int vol_prev = GMPDL_CHAN_VOL_INVALID;
-	gboolean volume_locked = TRUE;
-	char tooltip_text[256];
-	GtkWidget *faders_vbox, *faders_hbox, *fader;
-	GtkWidget *lock_button_hbox, *buttons_hbox;
-	GtkWidget *lock_button_line1, *lock_button_line2;
-	GtkRequisition lock_button_hbox_requisition;
 
 	line = calloc(1, sizeof(gm_line_t));
 	if (NULL == line)
 		return (NULL);
 	line->dev = dev;
 	line->dev_line = dev_line;
-	line->container = gtk_box_new(GTK_ORIENTATION_VERTICAL,
-	    BORDER_WIDTH);
-	g_object_set_data(G_OBJECT(line->container),
-	    "__gtk_mixer_line", (void*)line);
-	g_signal_connect(line->container, "destroy",
-	    G_CALLBACK(gtk_mixer_line_destroy), line);
-
-	/* Disable gtk_mixer_line_fader_changed(). */
-	line->ignore_signals = TRUE;
-
-	/* Center and do not expand faders and lock button. */
-	faders_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, BORDER_WIDTH);
-	g_object_set(G_OBJECT(faders_vbox),
-	    "halign", GTK_ALIGN_CENTER,
-	    "valign", GTK_ALIGN_FILL,
-	    "vexpand", TRUE, NULL);
-	gtk_box_pack_start(GTK_BOX(line->container), faders_vbox, TRUE,
-	    TRUE, 0);
-	gtk_widget_show(faders_vbox);
-
-	faders_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, BORDER_WIDTH);
-	gtk_box_pack_start(GTK_BOX(faders_vbox), faders_hbox, TRUE,
-	    TRUE, 0);
-	gtk_widget_show(faders_hbox);
-
-	/* Create a fader for each channel. */
-	for (ch_idx = gmp_dev_line_chan_first(line->dev_line);
-	    ch_idx < MIXER_CHANNELS_COUNT;
-	    ch_idx = gmp_dev_line_chan_next(line->dev_line, ch_idx)) {
-		fader = gtk_scale_new_with_range(GTK_ORIENTATION_VERTICAL,
-		    0.0, 100.0 , 1.0);
-		line->channel_faders = g_list_append(line->channel_faders,
-		    fader);
-		gtk_scale_set_draw_value(GTK_SCALE(fader), FALSE);
-		gtk_range_set_inverted(GTK_RANGE(fader), TRUE);
-		g_object_set_data(G_OBJECT(fader),
-		    "__gtk_mixer_line_ch_idx", (void*)ch_idx);
-		/* Make read-only lines insensitive. */
-		if (dev_line->is_read_only) {
-			gtk_widget_set_sensitive(fader, FALSE);
-		}
-		gtk_box_pack_start(GTK_BOX(faders_hbox), fader, TRUE,
-		    TRUE, 0);
-		g_signal_connect(fader, "value-changed",
-		    G_CALLBACK(gtk_mixer_line_fader_changed), line);
-		gtk_range_set_value(GTK_RANGE(fader),
-		    dev_line->state.chan_vol[ch_idx]);
-		gtk_widget_show(fader);
-
-		/* Equal volume across all channels means the line is locked. */
-		if (volume_locked && GMPDL_CHAN_VOL_INVALID != vol_prev &&
-		    dev_line->state.chan_vol[ch_idx] != vol_prev) {
-			volume_locked = FALSE;
-		}
-		vol_prev = dev_line->state.chan_vol[ch_idx];
-	}
-
-	/* Create lock button with lines. */
-	lock_button_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-	gtk_box_pack_start(GTK_BOX(faders_vbox), lock_button_hbox,
-	    FALSE, FALSE, 0);
-	gtk_widget_show(lock_button_hbox);
-
-	/* Left L-shaped line. */
-	lock_button_line1 = gtk_drawing_area_new();
-	gtk_widget_set_size_request(lock_button_line1,
-	    (BORDER_WIDTH * 2), 8);
-	gtk_box_pack_start(GTK_BOX(lock_button_hbox), lock_button_line1,
-	    TRUE, TRUE, 0);
-	g_signal_connect(G_OBJECT(lock_button_line1), "draw",
-	    G_CALLBACK(gtk_mixer_line_lock_button_line_draw),
-	    GINT_TO_POINTER(GTK_POS_LEFT));
-	gtk_widget_show(lock_button_line1);
-
-	/* Lock button. */
-	snprintf(tooltip_text, sizeof(tooltip_text),
-	    _("Lock channels for %s together"), dev_line->display_name);
-	line->lock_button = gtk_toggle_button_new();
-	gtk_widget_set_tooltip_text(line->lock_button, tooltip_text);
-	/* Make button insensitive for read-only lines. */
-	if (dev_line->is_read_only) {
-		gtk_widget_set_sensitive(line->lock_button, FALSE);
-	}
-	g_signal_connect(line->lock_button, "toggled",
-	    G_CALLBACK(gtk_mixer_line_lock_toggled), line);
-	gtk_box_pack_start(GTK_BOX(lock_button_hbox), line->lock_button,
-	    FALSE, FALSE, 0);
-	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(line->lock_button),
-	    volume_locked);
-	gtk_widget_show(line->lock_button);
-
-	/* Right L-shaped line. */
-	lock_button_line2 = gtk_drawing_area_new();
-	gtk_widget_set_size_request(lock_button_line2,
-	    (BORDER_WIDTH * 2), 8);
-	gtk_box_pack_start(GTK_BOX(lock_button_hbox), lock_button_line2,
-	    TRUE, TRUE, 0);
-	g_signal_connect(G_OBJECT(lock_button_line2), "draw",
-	    G_CALLBACK(gtk_mixer_line_lock_button_line_draw),
-	    GINT_TO_POINTER(GTK_POS_RIGHT));
-	gtk_widget_show(lock_button_line2);
-
-	/* Destroy the chain button and lines and replace them with an
-	 * equally sized placeholder if there is only one fader. */
-	if (dev_line->chan_vol_count == 1) {
-		gtk_widget_get_preferred_size(lock_button_hbox, NULL,
-		    &lock_button_hbox_requisition);
-		gtk_widget_destroy(lock_button_hbox);
-		lock_button_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-		gtk_widget_set_size_request(lock_button_hbox,
-		    lock_button_hbox_requisition.width,
-		    lock_button_hbox_requisition.height);
-		gtk_box_pack_start(GTK_BOX(faders_vbox), lock_button_hbox,
-		    FALSE, FALSE, 0);
-		gtk_widget_show(lock_button_hbox);
-	}
-
-	buttons_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL,
-	    (BORDER_WIDTH * 2));
-	g_object_set(G_OBJECT(buttons_hbox),
-	    "halign", GTK_ALIGN_CENTER,
-	    "valign", GTK_ALIGN_END, NULL);
-	gtk_box_pack_start(GTK_BOX(line->container), buttons_hbox, FALSE,
-	    FALSE, 0);
-	gtk_widget_show(buttons_hbox);
-
-	/* Mute/record button. */
-	line->enable_button = gtk_toggle_button_new();
-	snprintf(tooltip_text, sizeof(tooltip_text),
-	    _("Enable/disable line %s"),
-	    dev_line->display_name);
-	gtk_widget_set_tooltip_text(line->enable_button, tooltip_text);
-	/* Make button insensitive for read-only lines. */
-	if (dev_line->is_read_only) {
-		gtk_widget_set_sensitive(line->enable_button, FALSE);
-	}
-	g_signal_connect(line->enable_button, "toggled",
-	    G_CALLBACK(gtk_mixer_line_enable_toggled), line);
-	gtk_box_pack_start(GTK_BOX(buttons_hbox),
-	    line->enable_button, FALSE, FALSE, 0);
-	gtk_widget_show(line->enable_button);
-
-	/* Some of the mixer controls need to be updated before they
-	 * can be used. */
+	line->gen = dev_line->gen;
+	/* Equal volume across all channels means the line is locked. */
+	line->is_locked = 1;
+	for (size_t i = 1; i < dev_line->chan_vol_count; i ++) {
+		if (dev_line->state.chan_vol[i] == dev_line->state.chan_vol[0])
+			continue;
+		line->is_locked = 0;
+		break;
+	}
 	gtk_mixer_line_icon_update(line);
-	line->ignore_signals = FALSE;
 
-	return (line->container);
+	/* One widget draw all line controls. */
+	line->widget = gtk_drawing_area_new();
+	g_object_set_data(G_OBJECT(line->widget),
+	    "__gtk_mixer_line", (void*)line);
+	gtk_widget_set_can_focus(line->widget, TRUE);
+	gtk_widget_set_has_tooltip(line->widget, TRUE);
+	gtk_widget_add_events(line->widget,
+	    (GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK |
+	    GDK_POINTER_MOTION_MASK | GDK_LEAVE_NOTIFY_MASK |
+	    GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK | GDK_KEY_PRESS_MASK));
+	g_signal_connect(line->widget, "destroy",
+	    G_CALLBACK(gtk_mixer_line_destroy), line);
+	g_signal_connect(line->widget, "draw",
+	    G_CALLBACK(gtk_mixer_line_draw), line);
+	g_signal_connect(line->widget, "style-updated",
+	    G_CALLBACK(gtk_mixer_line_style_updated), line);
+	g_signal_connect(line->widget, "button-press-event",
+	    G_CALLBACK(gtk_mixer_line_button_press), line);
+	g_signal_connect(line->widget, "button-release-event",
+	    G_CALLBACK(gtk_mixer_line_button_release), line);
+	g_signal_connect(line->widget, "motion-notify-event",
+	    G_CALLBACK(gtk_mixer_line_motion), line);
+	g_signal_connect(line->widget, "leave-notify-event",
+	    G_CALLBACK(gtk_mixer_line_leave), line);
+	g_signal_connect(line->widget, "scroll-event",
+	    G_CALLBACK(gtk_mixer_line_scroll), line);
+	g_signal_connect(line->widget, "key-press-event",
+	    G_CALLBACK(gtk_mixer_line_key_press), line);
+	g_signal_connect(line->widget, "query-tooltip",
+	    G_CALLBACK(gtk_mixer_line_query_tooltip), line);
+	gtk_mixer_line_size_update(line);
+
+	return (line->widget);
 }
 
 void
-gtk_mixer_line_update(GtkWidget *container) {
-	size_t ch_idx;
-	GList *iter;
-	gm_line_p line = g_object_get_data(G_OBJECT(container),
+gtk_mixer_line_update(GtkWidget *widget) {
+	gm_line_p line = g_object_get_data(G_OBJECT(widget),
 	    "__gtk_mixer_line");
 
-	if (NULL == container || NULL == line || NULL == line->dev_line)
-		return;
-	if (0 >= line->dev_line->is_updated)
+	if (NULL == widget || NULL == line || NULL == line->dev_line)
 		return;
+	if (line->gen == line->dev_line->gen)
+		return; /* Shown or changed by this widget. */
+	line->gen = line->dev_line->gen;
 
-	line->ignore_signals = TRUE;
-	for (iter = line->channel_faders; iter != NULL; iter = g_list_next(iter)) {
-		ch_idx = (size_t)g_object_get_data(G_OBJECT(iter->data),
-		    "__gtk_mixer_line_ch_idx");
-		gtk_range_set_value(GTK_RANGE(iter->data),
-		    line->dev_line->state.chan_vol[ch_idx]);
-	}
 	gtk_mixer_line_icon_update(line);
-	line->ignore_signals = FALSE;
+	gtk_widget_queue_draw(widget);
+}
+
+size_t
+gtk_mixer_line_icons_loads(void) {
+
+	return (gm_line_icons_loads);
 }
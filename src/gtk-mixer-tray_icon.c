@@ -41,12 +41,13 @@ typedef struct gtk_mixer_tray_icon_s {
 	GtkWidget *main_window;
 	gmp_dev_p dev;
 	gmp_dev_line_p dev_line;
+	uint64_t gen; /* dev_line->gen shown by icon. */
 } gm_tray_icon_t, *gm_tray_icon_p;
 
 
 
 static gboolean
-gtk_mixer_tray_icon_scroll(GtkStatusIcon *status_icon,
+gtk_mixer_tray_icon_scroll(GtkStatusIcon *status_icon __unused,
     GdkEventScroll *event, gpointer user_data) {
 	gm_tray_icon_p tray_icon = user_data;
 
@@ -61,11 +62,11 @@ gtk_mixer_tray_icon_scroll(GtkStatusIcon *status_icon,
 	case GDK_SCROLL_DOWN:
 		gmp_dev_line_vol_glob_add(tray_icon->dev_line,
 		    ((GDK_SCROLL_UP == event->direction) ? 1 : -1));
-		tray_icon->dev_line->is_updated = 1;
-		tray_icon->dev_line->write_required ++;
-		gmp_dev_write(tray_icon->dev, 0);
+		gmp_dev_line_changed(tray_icon->dev_line, 1);
+		gtk_mixer_window_dev_write(tray_icon->main_window,
+		    tray_icon->dev);
+		/* Window lines and tray icon. */
 		gtk_mixer_window_lines_update(tray_icon->main_window);
-		gtk_mixer_tray_icon_update(status_icon);
 		break;
 	default:
 		break;
@@ -75,7 +76,7 @@ gtk_mixer_tray_icon_scroll(GtkStatusIcon *status_icon,
 }
 
 static gboolean
-gtk_mixer_tray_icon_release(GtkStatusIcon *status_icon,
+gtk_mixer_tray_icon_release(GtkStatusIcon *status_icon __unused,
     GdkEventButton *event, gpointer user_data) {
 	gm_tray_icon_p tray_icon = user_data;
 
@@ -89,10 +90,12 @@ gtk_mixer_tray_icon_release(GtkStatusIcon *status_icon,
 	case 2:
 		tray_icon->dev_line->state.is_enabled =
 		    ((0 != tray_icon->dev_line->state.is_enabled) ? 0 : 1);
-		tray_icon->dev_line->is_updated = 1; /* Mixer must update controls. */
-		tray_icon->dev_line->write_required ++;
-		gmp_dev_write(tray_icon->dev, 0);
-		gtk_mixer_tray_icon_update(status_icon);
+		/* Mixer will update controls. */
+		gmp_dev_line_changed(tray_icon->dev_line, 1);
+		gtk_mixer_window_dev_write(tray_icon->main_window,
+		    tray_icon->dev);
+		gtk_mixer_window_dev_write_flush(tray_icon->main_window);
+		gtk_mixer_window_lines_update(tray_icon->main_window);
 		break;
 	case 3:
 		//tray_icon_menu_show(user_data);
@@ -102,32 +105,38 @@ gtk_mixer_tray_icon_release(GtkStatusIcon *status_icon,
 	return (FALSE);
 }
 
-void
-gtk_mixer_tray_icon_update(GtkStatusIcon *status_icon) {
-	gm_tray_icon_p tray_icon = g_object_get_data(G_OBJECT(status_icon),
-	    "__gtk_mixer_tray_icon");
-	const char *stock = NULL, *display_name = "";
+static gboolean
+gtk_mixer_tray_icon_query_tooltip(GtkStatusIcon *status_icon __unused,
+    gint x __unused, gint y __unused, gboolean keyboard_mode __unused,
+    GtkTooltip *tooltip, gpointer user_data) {
+	gm_tray_icon_p tray_icon = user_data;
+	const char *display_name = "";
+	int vol = 0;
 	char tool_tip[256];
+
+	if (NULL != tray_icon->dev_line) {
+		vol = gmp_dev_line_vol_max_get(tray_icon->dev_line);
+		display_name = tray_icon->dev_line->display_name;
+	}
+	snprintf(tool_tip, sizeof(tool_tip), "%s: %i%%", display_name, vol);
+	gtk_tooltip_set_text(tooltip, tool_tip);
+
+	return (TRUE);
+}
+
+static void
+gtk_mixer_tray_icon_show(gm_tray_icon_p tray_icon) {
+	const char *stock = NULL;
 	int vol = 0, is_enabled = 0, is_capture = 0;
 
-	if (NULL == tray_icon)
-		return;
 	if (NULL != tray_icon->dev_line) {
-		if (0 == tray_icon->dev_line->is_updated)
-			return; /* No changes. */
+		tray_icon->gen = tray_icon->dev_line->gen;
 		vol = gmp_dev_line_vol_max_get(tray_icon->dev_line);
 		is_enabled = tray_icon->dev_line->state.is_enabled;
 		is_capture = tray_icon->dev_line->is_capture;
-		display_name = tray_icon->dev_line->display_name;
 	}
 
-	/* Tool tip. */
-	snprintf(tool_tip, sizeof(tool_tip), "%s: %i%%", display_name, vol);
-	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-	gtk_status_icon_set_tooltip_text(tray_icon->status_icon, tool_tip);
-	G_GNUC_END_IGNORE_DEPRECATIONS
-
-	/* Icon. */
+	/* Icon, tool tip is generated on query-tooltip. */
 	stock = volume_stock_from_level(is_capture, is_enabled, vol,
 	    tray_icon->icon_name);
 	if (NULL != stock) { /* Update icon. */
@@ -139,8 +148,21 @@ gtk_mixer_tray_icon_update(GtkStatusIcon *status_icon) {
 	}
 }
 
+void
+gtk_mixer_tray_icon_update(GtkStatusIcon *status_icon) {
+	gm_tray_icon_p tray_icon = g_object_get_data(G_OBJECT(status_icon),
+	    "__gtk_mixer_tray_icon");
+
+	if (NULL == tray_icon || NULL == tray_icon->dev_line)
+		return;
+	if (tray_icon->gen == tray_icon->dev_line->gen)
+		return; /* No changes. */
+	gtk_mixer_tray_icon_show(tray_icon);
+}
+
 void
 gtk_mixer_tray_icon_dev_set(GtkStatusIcon *status_icon, gmp_dev_p dev) {
+	gmp_dev_line_p dev_line;
 	gm_tray_icon_p tray_icon = g_object_get_data(G_OBJECT(status_icon),
 	    "__gtk_mixer_tray_icon");
 
@@ -151,20 +173,21 @@ gtk_mixer_tray_icon_dev_set(GtkStatusIcon *status_icon, gmp_dev_p dev) {
 	    0 == dev->lines_count) {
 		tray_icon->dev = NULL;
 		tray_icon->dev_line = NULL;
-		gtk_mixer_tray_icon_update(status_icon);
+		gtk_mixer_tray_icon_show(tray_icon);
 		return;
 	}
 	/* Use any line by default. */
 	tray_icon->dev = dev;
-	tray_icon->dev_line = &dev->lines[0];
+	tray_icon->dev_line = gmp_dev_line_get(dev, 0);
 	/* Try to get first playback device. */
 	for (size_t i = 0; i < dev->lines_count; i ++) {
-		if (dev->lines[i].is_capture)
+		dev_line = gmp_dev_line_get(dev, i);
+		if (dev_line->is_capture)
 			continue;
-		tray_icon->dev_line = &dev->lines[i];
+		tray_icon->dev_line = dev_line;
 		break;
 	}
-	gtk_mixer_tray_icon_update(status_icon);
+	gtk_mixer_tray_icon_show(tray_icon);
 }
 
 GtkStatusIcon *
@@ -188,8 +211,14 @@ gtk_mixer_tray_icon_create(GtkWidget *main_window) {
 	g_signal_connect(G_OBJECT(tray_icon->status_icon),
 	    "button-release-event",
 	    G_CALLBACK(gtk_mixer_tray_icon_release), tray_icon);
+	g_signal_connect(G_OBJECT(tray_icon->status_icon),
+	    "query-tooltip",
+	    G_CALLBACK(gtk_mixer_tray_icon_query_tooltip), tray_icon);
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	gtk_status_icon_set_has_tooltip(tray_icon->status_icon, TRUE);
+	G_GNUC_END_IGNORE_DEPRECATIONS
 
-	gtk_mixer_tray_icon_update(tray_icon->status_icon);
+	gtk_mixer_tray_icon_show(tray_icon);
 
 	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 	gtk_status_icon_set_visible(tray_icon->status_icon, TRUE);
@@ -23,10 +23,22 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <inttypes.h>
+#include <errno.h>
 
 #include "gtk-mixer.h"
 
 
+/* Initialized device with built controls. */
+typedef struct gtk_mixer_window_dev_cache_s {
+	gmp_dev_p dev;
+	GtkWidget *container; /* NULL while device init in progress. */
+	uint64_t refresh_gen; /* Device gen shown by lines widgets. */
+	int error; /* Init failed, retry only on device select. */
+} gm_dev_cache_t, *gm_dev_cache_p;
+
+/* Devices that stay initialized, switch to cached device is page swap. */
+#define DEV_CACHE_SIZE		4
+
 typedef struct gtk_mixer_window_s {
 	GtkWidget *window;
 
@@ -38,10 +50,312 @@ typedef struct gtk_mixer_window_s {
 	GtkWidget *makedef_button;
 	GtkWidget *makedef_menu;
 
-	/* Active mixer control set. */
-	GtkWidget *mixer_container;
+	/* Mixer control sets of cached devices, one visible. */
+	GtkWidget *mixer_stack;
+	/* Shown while current device init in progress. */
+	GtkWidget *activate_page;
+	GtkWidget *activate_spinner;
+	GtkWidget *activate_label;
+	/* Initialized devices LRU, current device first. */
+	gm_dev_cache_t dev_cache[DEV_CACHE_SIZE];
+	size_t dev_cache_count;
+
+	/* UI-originated writes: lines marked in write_mask, device write
+	 * is done once per frame clock tick or on idle if not mapped. */
+	gmp_dev_p write_dev; /* Device with pending lines writes. */
+	guint write_tick_id;
+	guint write_idle_id;
+
+	/* Lines changes: widgets update for lines changed since
+	 * refresh_gen is done once per frame clock tick. While window is
+	 * not mapped only tray icon is updated and lines widgets are
+	 * refreshed on map. */
+	GtkStatusIcon *status_icon;
+	guint refresh_tick_id;
+	guint refresh_timer_id;
 } gm_window_t, *gm_window_p;
 
+/* Tray icon refresh interval if window is not mapped, ms. */
+#define REFRESH_INTERVAL_UNMAPPED	16
+
+
+static void
+gtk_mixer_window_write_cancel(gm_window_p gm_win) {
+
+	gm_win->write_dev = NULL;
+	if (0 != gm_win->write_tick_id) {
+		gtk_widget_remove_tick_callback(gm_win->window,
+		    gm_win->write_tick_id);
+		gm_win->write_tick_id = 0;
+	}
+	if (0 != gm_win->write_idle_id) {
+		g_source_remove(gm_win->write_idle_id);
+		gm_win->write_idle_id = 0;
+	}
+}
+
+static void
+gtk_mixer_window_write(gm_window_p gm_win) {
+	gmp_dev_p dev = gm_win->write_dev;
+
+	gtk_mixer_window_write_cancel(gm_win);
+	if (NULL == dev)
+		return;
+	/* Busy: rest is written on previous write completion. */
+	gmp_dev_write_async(dev);
+}
+
+static gboolean
+gtk_mixer_window_write_tick(GtkWidget *widget __unused,
+    GdkFrameClock *frame_clock __unused, gpointer user_data) {
+	gm_window_p gm_win = user_data;
+
+	gm_win->write_tick_id = 0; /* Removed by return value. */
+	gtk_mixer_window_write(gm_win);
+
+	return (G_SOURCE_REMOVE);
+}
+
+static gboolean
+gtk_mixer_window_write_idle(gpointer user_data) {
+	gm_window_p gm_win = user_data;
+
+	gm_win->write_idle_id = 0; /* Removed by return value. */
+	gtk_mixer_window_write(gm_win);
+
+	return (G_SOURCE_REMOVE);
+}
+
+
+/* Current device cache entry if device initialized and its controls
+ * shown, else NULL. */
+static gm_dev_cache_p
+gtk_mixer_window_dev_active(gm_window_p gm_win) {
+
+	if (0 == gm_win->dev_cache_count ||
+	    NULL == gm_win->dev_cache[0].container ||
+	    gm_win->dev_cache[0].dev !=
+	    gtk_mixer_devs_combo_cur_get(gm_win->soundcard_combo))
+		return (NULL);
+
+	return (&gm_win->dev_cache[0]);
+}
+
+/* uninit - 0 if device will be destroyed by owner. */
+static void
+gtk_mixer_window_dev_cache_remove(gm_window_p gm_win, const size_t idx,
+    const int uninit) {
+	gm_dev_cache_p dev_cache = &gm_win->dev_cache[idx];
+
+	if (NULL != dev_cache->container) {
+		gtk_widget_destroy(dev_cache->container);
+	}
+	if (0 != uninit) {
+		gmp_dev_uninit_async(dev_cache->dev);
+	}
+	gm_win->dev_cache_count --;
+	memmove(dev_cache, &dev_cache[1],
+	    ((gm_win->dev_cache_count - idx) * sizeof(gm_dev_cache_t)));
+}
+
+/* Move device to cache head, least recently used device is
+ * uninitialized if cache is full. */
+static gm_dev_cache_p
+gtk_mixer_window_dev_cache_get(gm_window_p gm_win, gmp_dev_p dev) {
+	size_t idx;
+	gm_dev_cache_t dev_cache;
+
+	for (idx = 0; idx < gm_win->dev_cache_count; idx ++) {
+		if (dev == gm_win->dev_cache[idx].dev)
+			break;
+	}
+	if (idx < gm_win->dev_cache_count) {
+		dev_cache = gm_win->dev_cache[idx];
+	} else { /* Not cached. */
+		if (DEV_CACHE_SIZE == gm_win->dev_cache_count) {
+			gtk_mixer_window_dev_cache_remove(gm_win,
+			    (gm_win->dev_cache_count - 1), 1);
+		}
+		memset(&dev_cache, 0x00, sizeof(gm_dev_cache_t));
+		dev_cache.dev = dev;
+		idx = gm_win->dev_cache_count;
+		gm_win->dev_cache_count ++;
+	}
+	memmove(&gm_win->dev_cache[1], &gm_win->dev_cache[0],
+	    (idx * sizeof(gm_dev_cache_t)));
+	gm_win->dev_cache[0] = dev_cache;
+
+	return (&gm_win->dev_cache[0]);
+}
+
+static void
+gtk_mixer_window_activate_page_show(gm_window_p gm_win, const int spin,
+    const char *msg) {
+
+	if (0 != spin) {
+		gtk_spinner_start(GTK_SPINNER(gm_win->activate_spinner));
+		gtk_widget_show(gm_win->activate_spinner);
+	} else {
+		gtk_spinner_stop(GTK_SPINNER(gm_win->activate_spinner));
+		gtk_widget_hide(gm_win->activate_spinner);
+	}
+	gtk_label_set_text(GTK_LABEL(gm_win->activate_label), msg);
+	gtk_stack_set_visible_child(GTK_STACK(gm_win->mixer_stack),
+	    gm_win->activate_page);
+}
+
+/* Build controls for current device if its init done.
+ * Return non zero if current device become active. */
+static int
+gtk_mixer_window_dev_activate_try(gm_window_p gm_win) {
+	int error;
+	char msg[256];
+	gm_dev_cache_p dev_cache;
+
+	if (0 == gm_win->dev_cache_count)
+		return (0);
+	dev_cache = &gm_win->dev_cache[0];
+	if (NULL != dev_cache->container ||
+	    0 != dev_cache->error ||
+	    dev_cache->dev !=
+	    gtk_mixer_devs_combo_cur_get(gm_win->soundcard_combo))
+		return (0);
+
+	error = gmp_dev_init_async(dev_cache->dev);
+	if (EINPROGRESS == error) {
+		gtk_mixer_window_activate_page_show(gm_win, 1,
+		    _("Opening sound card..."));
+		return (0);
+	}
+	if (0 != error) {
+		dev_cache->error = error;
+		snprintf(msg, sizeof(msg), "%s: %s",
+		    _("Failed to open sound card"), strerror(error));
+		gtk_mixer_window_activate_page_show(gm_win, 0, msg);
+		return (0);
+	}
+	dev_cache->container = gtk_mixer_container_create();
+	if (NULL == dev_cache->container) {
+		dev_cache->error = ENOMEM;
+		return (0);
+	}
+	gtk_mixer_container_dev_set(dev_cache->container, dev_cache->dev);
+	dev_cache->refresh_gen = dev_cache->dev->gen;
+	gtk_container_add(GTK_CONTAINER(gm_win->mixer_stack),
+	    dev_cache->container);
+	gtk_widget_show(dev_cache->container);
+	gtk_stack_set_visible_child(GTK_STACK(gm_win->mixer_stack),
+	    dev_cache->container);
+	gtk_spinner_stop(GTK_SPINNER(gm_win->activate_spinner));
+
+	return (1);
+}
+
+
+static void
+gtk_mixer_window_refresh_cancel(gm_window_p gm_win) {
+
+	if (0 != gm_win->refresh_tick_id) {
+		gtk_widget_remove_tick_callback(gm_win->window,
+		    gm_win->refresh_tick_id);
+		gm_win->refresh_tick_id = 0;
+	}
+	if (0 != gm_win->refresh_timer_id) {
+		g_source_remove(gm_win->refresh_timer_id);
+		gm_win->refresh_timer_id = 0;
+	}
+}
+
+static void
+gtk_mixer_window_refresh(gm_window_p gm_win) {
+	gmp_dev_p dev;
+	gmp_dev_line_p dev_line;
+	gm_dev_cache_p dev_cache;
+
+	gtk_mixer_window_refresh_cancel(gm_win);
+	dev_cache = gtk_mixer_window_dev_active(gm_win);
+	if (NULL == dev_cache)
+		return;
+	dev = dev_cache->dev;
+	/* Not mapped: refresh_gen is kept, lines updated on map. */
+	if (gtk_widget_get_mapped(gm_win->window)) {
+		for (dev_line = gmp_dev_changes_first(dev,
+		    dev_cache->refresh_gen);
+		    NULL != dev_line;
+		    dev_line = gmp_dev_changes_next(dev_line,
+		    dev_cache->refresh_gen)) {
+			gtk_mixer_container_line_update(
+			    dev_cache->container, dev_line);
+		}
+		dev_cache->refresh_gen = dev->gen;
+	}
+	if (NULL != gm_win->status_icon) {
+		gtk_mixer_tray_icon_update(gm_win->status_icon);
+	}
+}
+
+static gboolean
+gtk_mixer_window_refresh_tick(GtkWidget *widget __unused,
+    GdkFrameClock *frame_clock __unused, gpointer user_data) {
+	gm_window_p gm_win = user_data;
+
+	gm_win->refresh_tick_id = 0; /* Removed by return value. */
+	gtk_mixer_window_refresh(gm_win);
+
+	return (G_SOURCE_REMOVE);
+}
+
+static gboolean
+gtk_mixer_window_refresh_timer(gpointer user_data) {
+	gm_window_p gm_win = user_data;
+
+	gm_win->refresh_timer_id = 0; /* Removed by return value. */
+	gtk_mixer_window_refresh(gm_win);
+
+	return (G_SOURCE_REMOVE);
+}
+
+static void
+gtk_mixer_window_refresh_schedule(gm_window_p gm_win) {
+
+	if (0 != gm_win->refresh_tick_id ||
+	    0 != gm_win->refresh_timer_id)
+		return; /* Already scheduled. */
+	if (gtk_widget_get_mapped(gm_win->window)) {
+		gm_win->refresh_tick_id = gtk_widget_add_tick_callback(
+		    gm_win->window, gtk_mixer_window_refresh_tick, gm_win,
+		    NULL);
+	} else {
+		gm_win->refresh_timer_id = g_timeout_add(
+		    REFRESH_INTERVAL_UNMAPPED,
+		    gtk_mixer_window_refresh_timer, gm_win);
+	}
+}
+
+static void
+gtk_mixer_window_map(GtkWidget *window __unused, gpointer user_data) {
+	gm_window_p gm_win = user_data;
+	gm_dev_cache_p dev_cache;
+
+	dev_cache = gtk_mixer_window_dev_active(gm_win);
+	if (NULL == dev_cache ||
+	    dev_cache->refresh_gen == dev_cache->dev->gen)
+		return;
+	gtk_mixer_window_refresh(gm_win);
+}
+
+static void
+gtk_mixer_window_unmap(GtkWidget *window __unused, gpointer user_data) {
+	gm_window_p gm_win = user_data;
+
+	/* Frame clock may stop: do not leave pending ticks. */
+	gtk_mixer_window_write(gm_win);
+	if (0 == gm_win->refresh_tick_id)
+		return;
+	gtk_mixer_window_refresh_cancel(gm_win);
+	gtk_mixer_window_refresh_schedule(gm_win);
+}
+
 
 static void
 gtk_mixer_window_soundcard_changed(GtkWidget *combo __unused,
@@ -49,9 +363,16 @@ gtk_mixer_window_soundcard_changed(GtkWidget *combo __unused,
 	gm_window_p gm_win = user_data;
 	char title[256];
 	gmp_dev_p dev;
+	gm_dev_cache_p dev_cache;
 
 	/* Update mixer controls for the active sound card */
 	dev = gtk_mixer_devs_combo_cur_get(gm_win->soundcard_combo);
+	/* Old device stay initialized in cache: flush its writes. */
+	if (dev != gm_win->write_dev) {
+		gtk_mixer_window_write(gm_win);
+	}
+	gtk_mixer_window_refresh_cancel(gm_win);
+	/* Before init request: plugin calls wait for init done. */
 	if (NULL != dev) {
 		snprintf(title, sizeof(title),
 		    "%s - %s", _("Audio Mixer"),
@@ -64,8 +385,20 @@ gtk_mixer_window_soundcard_changed(GtkWidget *combo __unused,
 		gtk_window_set_title(GTK_WINDOW(gm_win->window), _("Audio Mixer"));
 		gtk_widget_set_sensitive(gm_win->makedef_button, FALSE);
 	}
-	/* Update the MixerContainer containing the controls. */
-	gtk_mixer_container_dev_set(gm_win->mixer_container, dev);
+	if (NULL == dev) {
+		gtk_mixer_window_activate_page_show(gm_win, 0,
+		    _("No sound card"));
+		return;
+	}
+	/* Cached device: page swap, else build on init done. */
+	dev_cache = gtk_mixer_window_dev_cache_get(gm_win, dev);
+	dev_cache->error = 0;
+	if (NULL == dev_cache->container) {
+		gtk_mixer_window_dev_activate_try(gm_win);
+		return;
+	}
+	gtk_stack_set_visible_child(GTK_STACK(gm_win->mixer_stack),
+	    dev_cache->container);
 }
 
 static void
@@ -76,8 +409,8 @@ on_makedef_menu_click_handler(gpointer user_data, const uint32_t type) {
 	dev = gtk_mixer_devs_combo_cur_get(gm_win->soundcard_combo);
 	if (NULL == dev)
 		return;
-	gmp_dev_set_default(dev, type);
-	gtk_mixer_devs_combo_update(gm_win->soundcard_combo);
+	/* Combo is updated on devices list update. */
+	gmp_dev_set_default_async(dev, type);
 }
 static void
 on_makedef_menu_play_click(GtkMenuItem *menuitem __unused, gpointer user_data) {
@@ -145,6 +478,9 @@ gtk_mixer_window_destroy(GtkWidget *window __unused, gpointer user_data) {
 	//    gm_win->current_width, "window-height", gm_win->current_height,
 	//    NULL);
 
+	/* Done by worker before exit. */
+	gtk_mixer_window_write(gm_win);
+	gtk_mixer_window_refresh_cancel(gm_win);
 	free(gm_win);
 }
 
@@ -179,6 +515,10 @@ gtk_mixer_window_create(void) {
 	gtk_window_set_position(GTK_WINDOW(gm_win->window), GTK_WIN_POS_CENTER);
 	g_signal_connect(gm_win->window, "destroy",
 	    G_CALLBACK(gtk_mixer_window_destroy), gm_win);
+	g_signal_connect(gm_win->window, "map",
+	    G_CALLBACK(gtk_mixer_window_map), gm_win);
+	g_signal_connect(gm_win->window, "unmap",
+	    G_CALLBACK(gtk_mixer_window_unmap), gm_win);
 
 	vbox = gtk_dialog_get_content_area(GTK_DIALOG(gm_win->window));
 	gtk_widget_show(vbox);
@@ -214,10 +554,30 @@ gtk_mixer_window_create(void) {
 	gtk_box_pack_start(GTK_BOX(vbox), mixer_frame, TRUE, TRUE, 0);
 	gtk_widget_show(mixer_frame);
 
-	gm_win->mixer_container = gtk_mixer_container_create();
-	gtk_container_add(GTK_CONTAINER(mixer_frame),
-	    gm_win->mixer_container);
-	gtk_widget_show(gm_win->mixer_container);
+	gm_win->mixer_stack = gtk_stack_new();
+	/* Size by visible page only. */
+	gtk_stack_set_homogeneous(GTK_STACK(gm_win->mixer_stack), FALSE);
+	gtk_container_add(GTK_CONTAINER(mixer_frame), gm_win->mixer_stack);
+	gtk_widget_show(gm_win->mixer_stack);
+
+	gm_win->activate_page = gtk_box_new(GTK_ORIENTATION_VERTICAL,
+	    BORDER_WIDTH);
+	g_object_set(G_OBJECT(gm_win->activate_page),
+	    "halign", GTK_ALIGN_CENTER,
+	    "hexpand", TRUE,
+	    "valign", GTK_ALIGN_CENTER,
+	    "vexpand", TRUE,
+	    "border-width", BORDER_WIDTH, NULL);
+	gm_win->activate_spinner = gtk_spinner_new();
+	gtk_box_pack_start(GTK_BOX(gm_win->activate_page),
+	    gm_win->activate_spinner, FALSE, TRUE, 0);
+	gm_win->activate_label = gtk_label_new(NULL);
+	gtk_box_pack_start(GTK_BOX(gm_win->activate_page),
+	    gm_win->activate_label, FALSE, TRUE, 0);
+	gtk_widget_show(gm_win->activate_label);
+	gtk_container_add(GTK_CONTAINER(gm_win->mixer_stack),
+	    gm_win->activate_page);
+	gtk_widget_show(gm_win->activate_page);
 
 	/* Update mixer controls for the active sound card. */
 	gtk_mixer_window_soundcard_changed(NULL, gm_win);
@@ -258,8 +618,80 @@ gtk_mixer_window_dev_cur_set(GtkWidget *window, gmp_dev_p dev) {
 	gtk_mixer_devs_combo_cur_set(gm_win->soundcard_combo, dev);
 }
 
+gmp_dev_p
+gtk_mixer_window_dev_active_get(GtkWidget *window) {
+	gm_dev_cache_p dev_cache;
+	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
+	    "__gtk_mixer_window");
+
+	if (NULL == gm_win)
+		return (NULL);
+	dev_cache = gtk_mixer_window_dev_active(gm_win);
+	if (NULL == dev_cache)
+		return (NULL);
+
+	return (dev_cache->dev);
+}
+
+int
+gtk_mixer_window_dev_activate(GtkWidget *window) {
+	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
+	    "__gtk_mixer_window");
+
+	if (NULL == gm_win)
+		return (0);
+
+	return (gtk_mixer_window_dev_activate_try(gm_win));
+}
+
 void
-gtk_mixer_window_dev_list_update(GtkWidget *window, gmp_dev_list_p dev_list) {
+gtk_mixer_window_dev_set_event(GtkWidget *window, gmp_dev_p dev,
+    const int event, const size_t idx) {
+	char title[256];
+	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
+	    "__gtk_mixer_window");
+
+	if (NULL == gm_win || NULL == dev)
+		return;
+
+	/* Only affected row changed: current device stay initialized. */
+	switch (event) {
+	case GMP_DEV_SET_ADDED:
+		gtk_mixer_devs_combo_dev_add(gm_win->soundcard_combo,
+		    dev, idx);
+		break;
+	case GMP_DEV_SET_REMOVED:
+		/* Device will be destroyed, its pending writes too. */
+		if (dev == gm_win->write_dev) {
+			gtk_mixer_window_write_cancel(gm_win);
+		}
+		for (size_t i = 0; i < gm_win->dev_cache_count; i ++) {
+			if (dev != gm_win->dev_cache[i].dev)
+				continue;
+			if (0 == i) {
+				gtk_mixer_window_refresh_cancel(gm_win);
+			}
+			gtk_mixer_window_dev_cache_remove(gm_win, i, 0);
+			break;
+		}
+		gtk_mixer_devs_combo_dev_remove(gm_win->soundcard_combo,
+		    dev);
+		break;
+	case GMP_DEV_SET_CHANGED:
+		gtk_mixer_devs_combo_dev_update(gm_win->soundcard_combo,
+		    dev);
+		if (dev != gtk_mixer_devs_combo_cur_get(gm_win->soundcard_combo))
+			break;
+		snprintf(title, sizeof(title),
+		    "%s - %s", _("Audio Mixer"),
+		    dev->description);
+		gtk_window_set_title(GTK_WINDOW(gm_win->window), title);
+		break;
+	}
+}
+
+void
+gtk_mixer_window_dev_list_update(GtkWidget *window) {
 	gmp_dev_p dev;
 	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
 	    "__gtk_mixer_window");
@@ -267,12 +699,8 @@ gtk_mixer_window_dev_list_update(GtkWidget *window, gmp_dev_list_p dev_list) {
 	if (NULL == gm_win)
 		return;
 
-	/* Update dev list only if it can be changed. */
+	/* Update default devices marks only if it can be changed. */
 	dev = gtk_mixer_devs_combo_cur_get(gm_win->soundcard_combo);
-	if (NULL != dev_list) {
-		gtk_mixer_devs_combo_dev_list_set(gm_win->soundcard_combo,
-		    dev_list);
-	}
 	if (NULL != dev &&
 	    dev->plugin->descr->can_set_default_device) {
 		gtk_mixer_devs_combo_update(gm_win->soundcard_combo);
@@ -281,6 +709,17 @@ gtk_mixer_window_dev_list_update(GtkWidget *window, gmp_dev_list_p dev_list) {
 	}
 }
 
+void
+gtk_mixer_window_status_icon_set(GtkWidget *window,
+    GtkStatusIcon *status_icon) {
+	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
+	    "__gtk_mixer_window");
+
+	if (NULL == gm_win)
+		return;
+	gm_win->status_icon = status_icon;
+}
+
 void
 gtk_mixer_window_lines_update(GtkWidget *window) {
 	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
@@ -288,5 +727,43 @@ gtk_mixer_window_lines_update(GtkWidget *window) {
 
 	if (NULL == gm_win)
 		return;
-	gtk_mixer_container_update(gm_win->mixer_container);
+	gtk_mixer_window_refresh_schedule(gm_win);
+}
+
+void
+gtk_mixer_window_dev_write(GtkWidget *window, gmp_dev_p dev) {
+	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
+	    "__gtk_mixer_window");
+
+	if (NULL == dev)
+		return;
+	if (NULL == gm_win) { /* Write now. */
+		gmp_dev_write_async(dev);
+		return;
+	}
+	if (dev != gm_win->write_dev) {
+		gtk_mixer_window_write(gm_win);
+		gm_win->write_dev = dev;
+	}
+	if (0 != gm_win->write_tick_id ||
+	    0 != gm_win->write_idle_id)
+		return; /* Already scheduled. */
+	if (gtk_widget_get_mapped(gm_win->window)) {
+		gm_win->write_tick_id = gtk_widget_add_tick_callback(
+		    gm_win->window, gtk_mixer_window_write_tick, gm_win,
+		    NULL);
+	} else {
+		gm_win->write_idle_id = g_idle_add(
+		    gtk_mixer_window_write_idle, gm_win);
+	}
+}
+
+void
+gtk_mixer_window_dev_write_flush(GtkWidget *window) {
+	gm_window_p gm_win = g_object_get_data(G_OBJECT(window),
+	    "__gtk_mixer_window");
+
+	if (NULL == gm_win)
+		return;
+	gtk_mixer_window_write(gm_win);
 }
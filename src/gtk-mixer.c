@@ -35,105 +35,362 @@
 #include <inttypes.h>
 #include <getopt.h>
 
+#include <glib-unix.h>
+
 #include "gtk-mixer.h"
 
 
 typedef struct gtk_mixer_app_s {
 	gm_plugin_p	plugins;
 	size_t		plugins_count;
-	gmp_dev_list_t	dev_list;
+	gmp_dev_set_t	dev_set; /* Devices objects stay while present. */
 	GtkWidget	*window;
 	GtkStatusIcon	*status_icon;
 	GtkWidget	*tray_icon_menu;
 
+	int		hotplug_fd; /* Device nodes hotplug watcher. */
+	guint		hotplug_src_id;
+	guint		*worker_src_ids; /* Backend I/O workers results. */
+	GSource		*watchdog; /* Stalled backend calls check. */
+
 	gmp_dev_p	dev; /* Current sound device. */
+	int		dev_events; /* Current sound device events watched. */
 
-	/* GUI update rate scaler. */
-	size_t update_skip_counter;
-	size_t update_force_counter;
+	/* Update scheduler: one-shot timer, not armed if all event driven. */
+	guint		update_src_id;
+	guint		update_interval; /* ms */
+
+	int		stats; /* STATS_ENVVAR set: report to stderr. */
+	size_t		wakeups;
+	gint64		wakeups_time;
+	size_t		stalled; /* Stalled workers on last watchdog. */
 } gm_app_t, *gm_app_p;
 
-/* Check updates every 1s if no changes and every 100ms if something was
- * changes in last 5 second. */
-#define UPDATE_INTERVAL		100
-/* If no chenges - check every (UPDATE_INTERVAL * UPDATE_SKIP_MAX_COUNT) ms. */
-#define UPDATE_SKIP_MAX_COUNT	10
-/* If was changes - check every UPDATE_INTERVAL in next (UPDATE_INTERVAL * UPDATE_FORCE_MAX_COUNT) ms. */
-#define UPDATE_FORCE_MAX_COUNT	50
+/* Watchdog timer: armed only while workers busy, checked before each
+ * main loop poll, so it does not wake up idle app.
+ * Call from device events of idle app is checked on next wakeup. */
+typedef struct gtk_mixer_watchdog_source_s {
+	GSource		source;
+	gm_app_p	app;
+	gint64		deadline; /* Monotonic time, us, 0 - not armed. */
+} gm_watchdog_source_t, *gm_watchdog_source_p;
+
+/* Poll interval: UPDATE_INTERVAL_MIN after changes, doubled on each
+ * check without changes up to UPDATE_INTERVAL_MAX.
+ * Both multiplied by plugins poll cost. */
+#define UPDATE_INTERVAL_MIN	100
+#define UPDATE_INTERVAL_MAX	1000
+/* Backend call longer than this (us) mark plugin as stalled. */
+#define WORKER_STALL_TIMEOUT	(500 * 1000)
+/* Non empty and not "0": report stats to stderr. */
+#define STATS_ENVVAR		"GTK_MIXER_STATS"
+/* Report wakeups rate every N us. */
+#define WAKEUPS_REPORT_INTERVAL	(10 * G_USEC_PER_SEC)
+
+
+static void
+gtk_mixer_wakeup(gm_app_p app) {
+	gint64 now;
+
+	if (0 == app->stats)
+		return;
+	now = g_get_monotonic_time();
+	app->wakeups ++;
+	if (0 == app->wakeups_time) {
+		app->wakeups_time = now;
+	}
+	if (WAKEUPS_REPORT_INTERVAL > (now - app->wakeups_time))
+		return;
+	fprintf(stderr, "wakeups: %.2f/s, poll interval: %u ms, "
+	    "line icons loads: %zu.\n",
+	    (((double)app->wakeups * G_USEC_PER_SEC) /
+	    (double)(now - app->wakeups_time)),
+	    ((0 != app->update_src_id) ? app->update_interval : 0),
+	    gtk_mixer_line_icons_loads());
+	app->wakeups = 0;
+	app->wakeups_time = now;
+}
+
+/* Mark stalled plugins, report changes. Return stalled count. */
+static size_t
+gtk_mixer_watchdog(gm_app_p app) {
+	size_t stalled;
+
+	stalled = gmp_worker_watchdog(app->plugins, app->plugins_count,
+	    WORKER_STALL_TIMEOUT);
+	if (0 != app->stats && stalled != app->stalled) {
+		fprintf(stderr, "stalled workers: %zu", stalled);
+		for (size_t i = 0; i < app->plugins_count; i ++) {
+			if (0 == app->plugins[i].is_stalled)
+				continue;
+			fprintf(stderr, " %s", app->plugins[i].descr->name);
+		}
+		fprintf(stderr, ".\n");
+	}
+	app->stalled = stalled;
+
+	return (stalled);
+}
 
+static gboolean
+gtk_mixer_watchdog_prepare(GSource *source, gint *timeout) {
+	gint64 now;
+	gm_watchdog_source_p wd = (gm_watchdog_source_p)source;
+
+	/* Stalled plugins are checked until recovered. */
+	if (0 == gmp_worker_is_busy(wd->app->plugins,
+	    wd->app->plugins_count) &&
+	    0 == wd->app->stalled) {
+		wd->deadline = 0;
+		(*timeout) = -1;
+		return (FALSE);
+	}
+	now = g_source_get_time(source);
+	if (0 == wd->deadline) {
+		wd->deadline = (now + WORKER_STALL_TIMEOUT);
+	}
+	if (now >= wd->deadline) {
+		(*timeout) = 0;
+		return (TRUE);
+	}
+	(*timeout) = (gint)(((wd->deadline - now) + 999) / 1000);
+
+	return (FALSE);
+}
 
 static gboolean
-gtk_mixer_check_update(gm_app_p app) {
+gtk_mixer_watchdog_check(GSource *source) {
+	gm_watchdog_source_p wd = (gm_watchdog_source_p)source;
+
+	return (0 != wd->deadline &&
+	    g_source_get_time(source) >= wd->deadline);
+}
+
+static gboolean
+gtk_mixer_watchdog_dispatch(GSource *source, GSourceFunc callback __unused,
+    gpointer user_data __unused) {
+	gm_watchdog_source_p wd = (gm_watchdog_source_p)source;
+
+	wd->deadline = 0; /* Armed again by prepare if still busy. */
+	gtk_mixer_wakeup(wd->app);
+	gtk_mixer_watchdog(wd->app);
+
+	return (G_SOURCE_CONTINUE);
+}
+
+static GSourceFuncs gtk_mixer_watchdog_funcs = {
+	.prepare	= gtk_mixer_watchdog_prepare,
+	.check		= gtk_mixer_watchdog_check,
+	.dispatch	= gtk_mixer_watchdog_dispatch,
+};
+
+static void gtk_mixer_update_schedule(gm_app_p app, const int changed);
+static void gtk_mixer_soundcard_changed(GtkWidget *combo,
+    gpointer user_data);
+
+static size_t
+gtk_mixer_dev_lines_check(gm_app_p app, int force) {
 	int error;
-	size_t changes = 0;
-	gmp_dev_list_t dev_list;
-	gmp_dev_p dev = NULL;
+	uint64_t gen;
 
-	/* GUI update rate scaler. */
-	app->update_skip_counter ++;
-	if (UPDATE_SKIP_MAX_COUNT > app->update_skip_counter)
-		return (TRUE);
-	app->update_skip_counter = 0;
+	if (NULL == app->dev)
+		return (0);
+
+	/* With worker result will be handled by gtk_mixer_worker_cb(). */
+	gen = app->dev->gen;
+	error = gmp_dev_read_async(app->dev, force);
+	if (0 != error ||
+	    gen == app->dev->gen)
+		return (0);
+	/* GUI update on next frame. */
+	gtk_mixer_window_lines_update(app->window);
 
-	/* Devices list update check. */
-	if (gmp_is_list_devs_changed(app->plugins, app->plugins_count)) {
+	return (1);
+}
+
+static void
+gtk_mixer_dev_set_event(gmp_dev_p dev, const int event, const size_t idx,
+    void *udata) {
+	gm_app_p app = udata;
+
+	gtk_mixer_window_dev_set_event(app->window, dev, event, idx);
+}
+
+/* Merge scanned devices lists. */
+static size_t
+gtk_mixer_dev_set_apply(gm_app_p app) {
+
+	/* Current device keep its object and lines if still present. */
+	if (0 == gmp_dev_set_apply(&app->dev_set, app->plugins,
+	    app->plugins_count, gtk_mixer_dev_set_event, app))
+		return (0);
+	/* Current device removed: select new one. */
+	if (NULL == gtk_mixer_window_dev_cur_get(app->window)) {
+		gtk_mixer_window_dev_cur_set(app->window,
+		    gmp_dev_set_get_playback_default(&app->dev_set));
+	}
+	gtk_mixer_window_dev_list_update(app->window);
+
+	return (1);
+}
+
+static size_t
+gtk_mixer_dev_list_check(gm_app_p app) {
+	int list_changed, def_changed;
+
+	list_changed = gmp_is_list_devs_changed(app->plugins,
+	    app->plugins_count);
+	/* Always consumed: updated list also show new default device. */
+	def_changed = gmp_is_def_dev_changed(app->plugins,
+	    app->plugins_count);
+	/* Default devices flags are updated by list too. */
+	if (0 == list_changed && 0 == def_changed)
+		return (0);
+	/* Plugins with worker report lists via gtk_mixer_worker_cb(). */
+	gmp_list_devs_async(app->plugins, app->plugins_count);
+	gtk_mixer_dev_set_apply(app);
+
+	return (1);
+}
+
+static gboolean
+gtk_mixer_hotplug_cb(gint fd, GIOCondition condition __unused,
+    gpointer user_data) {
+	gm_app_p app = user_data;
+
+	gtk_mixer_wakeup(app);
+	if (0 == gmp_hotplug_handle_events(app->plugins, app->plugins_count,
+	    fd))
+		return (G_SOURCE_CONTINUE);
+	if (0 != gtk_mixer_dev_list_check(app)) {
+		/* Watcher may fallback to polling. */
+		gtk_mixer_update_schedule(app, 1);
+	}
+
+	return (G_SOURCE_CONTINUE);
+}
+
+static gboolean
+gtk_mixer_worker_cb(gint fd __unused, GIOCondition condition __unused,
+    gpointer user_data) {
+	gm_app_p app = user_data;
+	uint32_t res = 0;
+	size_t changes = 0;
+
+	gtk_mixer_wakeup(app);
+	for (size_t i = 0; i < app->plugins_count; i ++) {
+		res |= gmp_worker_handle_results(&app->plugins[i]);
+	}
+	if (0 != (GMP_WORKER_RES_LINES & res)) {
+		/* GUI update on next frame. */
+		gtk_mixer_window_lines_update(app->window);
 		changes ++;
-		memset(&dev_list, 0x00, sizeof(dev_list));
-		error = gmp_list_devs(app->plugins, app->plugins_count,
-		    &dev_list);
-		if (0 == error) {
-			/* Try to find old current dev in updated dev list. */
-			dev = gmp_dev_find_same(&dev_list, app->dev);
-			gtk_mixer_window_dev_list_update(app->window,
-			    &dev_list);
-			gmp_dev_list_clear(&app->dev_list);
-			app->dev_list = dev_list;
-			/* Select new current device. */
-			if (NULL == dev) {
-				dev = gmp_dev_list_get_playback_default(&app->dev_list);
-			}
-			gtk_mixer_window_dev_cur_set(app->window, dev);
-		}
-	} else if (0 != gmp_is_def_dev_changed(app->plugins,
-	    app->plugins_count)) { /* Default device changed. */
+	}
+	if (0 != (GMP_WORKER_RES_EVENTS & res)) {
+		/* Deferred attach done or fallback to polling by timer. */
+		app->dev_events = gmp_worker_dev_events_attached(app->dev);
 		changes ++;
-		gtk_mixer_window_dev_list_update(app->window, NULL);
-	}
-
-	/* Check lines update for current device. */
-	if (NULL != app->dev) {
-		error = gmp_dev_read(app->dev, 1);
-		if (0 == error && 
-		    gmp_dev_is_updated(app->dev)) {
-			/* GUI update. */
-			gtk_mixer_window_lines_update(app->window);
-			gtk_mixer_tray_icon_update(app->status_icon);
-			changes += gmp_dev_is_updated_clear(app->dev);
-		}
 	}
-
-	/* GUI update rate scaler. */
-	/* If something changed than force check updates on next timer fire. */
+	if (0 != (GMP_WORKER_RES_INIT & res) &&
+	    0 != gtk_mixer_window_dev_activate(app->window)) {
+		/* Current device init done. */
+		gtk_mixer_soundcard_changed(NULL, app);
+	}
+	if (0 != (GMP_WORKER_RES_CHECK & res)) {
+		changes += gtk_mixer_dev_list_check(app);
+	}
+	if (0 != (GMP_WORKER_RES_LIST & res)) {
+		changes += gtk_mixer_dev_set_apply(app);
+	}
 	if (0 != changes) {
-		app->update_force_counter = UPDATE_FORCE_MAX_COUNT;
+		gtk_mixer_update_schedule(app, 1);
 	}
-	if (0 != app->update_force_counter) {
-		app->update_force_counter --;
-		app->update_skip_counter = UPDATE_SKIP_MAX_COUNT;
+
+	return (G_SOURCE_CONTINUE);
+}
+
+static gboolean
+gtk_mixer_check_update(gm_app_p app) {
+	size_t changes = 0;
+
+	app->update_src_id = 0; /* One-shot. */
+	gtk_mixer_wakeup(app);
+
+	/* Devices list update check: only for plugins without hotplug
+	 * watcher or default device notify.
+	 * Plugins with worker report results via gtk_mixer_worker_cb(). */
+	gmp_check_async(app->plugins, app->plugins_count);
+	changes += gtk_mixer_dev_list_check(app);
+
+	/* Attach deferred by busy worker: retry. */
+	if (0 == app->dev_events) {
+		app->dev_events = gmp_worker_dev_attach(app->dev);
 	}
 
-	return (TRUE);
+	/* Check lines update for current device.
+	 * Event driven devices report changes via worker. */
+	if (0 != gmp_dev_is_poll_required(app->dev, app->dev_events)) {
+		changes += gtk_mixer_dev_lines_check(app, 1);
+	}
+
+	gtk_mixer_update_schedule(app, (0 != changes));
+
+	return (G_SOURCE_REMOVE);
 }
 
+/* Arm one-shot update timer if something must be polled. */
 static void
-gtk_mixer_soundcard_changed(GtkWidget *combo __unused,
+gtk_mixer_update_schedule(gm_app_p app, const int changed) {
+	guint cost, interval;
+
+	cost = gmp_poll_cost(app->plugins, app->plugins_count);
+	if (0 == gmp_is_poll_required(app->plugins, app->plugins_count) &&
+	    0 == gmp_dev_is_poll_required(app->dev, app->dev_events)) {
+		/* All event driven: no timer. */
+		interval = 0;
+	} else if (0 != changed || 0 == app->update_interval) {
+		interval = (UPDATE_INTERVAL_MIN * cost);
+	} else { /* Exponential backoff. */
+		interval = MIN((app->update_interval * 2),
+		    (UPDATE_INTERVAL_MAX * cost));
+	}
+	if (0 != app->update_src_id) {
+		if (interval == app->update_interval)
+			return; /* Already armed. */
+		g_source_remove(app->update_src_id);
+		app->update_src_id = 0;
+	}
+	app->update_interval = interval;
+	if (0 == interval)
+		return;
+	app->update_src_id = g_timeout_add(interval,
+	    (GSourceFunc)gtk_mixer_check_update, app);
+}
+
+/* combo - NULL if called not by user device select. */
+static void
+gtk_mixer_soundcard_changed(GtkWidget *combo,
     gpointer user_data) {
 	gm_app_p app = user_data;
+	gmp_dev_p dev;
 
 	if (NULL == app)
 		return;
 
-	app->dev = gtk_mixer_window_dev_cur_get(app->window);
+	/* NULL while device init in progress. */
+	dev = gtk_mixer_window_dev_active_get(app->window);
+	if (dev != app->dev) {
+		/* Stay initialized in window cache, without I/O. */
+		gmp_worker_dev_detach(app->dev);
+	}
+	app->dev = dev;
+	/* Without worker device events are not watched. */
+	app->dev_events = gmp_worker_dev_attach(app->dev);
+	if (NULL != combo) {
+		/* Cached device state may be outdated. */
+		gtk_mixer_dev_lines_check(app, 1);
+	}
+	gtk_mixer_update_schedule(app, 1);
 
 	/* Tray icon.*/
 	gtk_mixer_tray_icon_dev_set(app->status_icon, app->dev);
@@ -226,7 +483,9 @@ gtk_mixer_status_icon_menu(GtkStatusIcon *status_icon __unused,
 int
 main(int argc, char **argv) {
 	int error;
-	int ch, opt_idx = -1, start_hidden = 0;
+	int ch, fd, opt_idx = -1, start_hidden = 0;
+	size_t hung = 0;
+	const char *stats;
 	gm_app_t app;
 	gmp_dev_p dev = NULL;
 	struct option long_options[] = {
@@ -239,13 +498,19 @@ main(int argc, char **argv) {
 	while ((ch = getopt_long_only(argc, argv, "", long_options,
 	    &opt_idx)) != -1) {
 	}
+	stats = getenv(STATS_ENVVAR);
+	app.stats = (NULL != stats && 0 != stats[0] &&
+	    0 != strcmp(stats, "0"));
 
 
 	error = gmp_init(&app.plugins, &app.plugins_count);
 	if (0 != error)
 		return (error);
-	error = gmp_list_devs(app.plugins, app.plugins_count,
-	    &app.dev_list);
+	app.worker_src_ids = calloc((app.plugins_count + 1), sizeof(guint));
+	if (NULL == app.worker_src_ids)
+		return (ENOMEM);
+	/* Workers are not started yet: listed right now. */
+	error = gmp_list_devs_async(app.plugins, app.plugins_count);
 	if (0 != error)
 		return (error);
 
@@ -259,7 +524,8 @@ main(int argc, char **argv) {
 
 	/* Main window. */
 	app.window = gtk_mixer_window_create();
-	gtk_mixer_window_dev_list_update(app.window, &app.dev_list);
+	gmp_dev_set_apply(&app.dev_set, app.plugins, app.plugins_count,
+	    gtk_mixer_dev_set_event, &app);
 #if 0
 	if (card_name != NULL) {
 		dev = gtk_mixer_get_card(card_name);
@@ -271,13 +537,14 @@ main(int argc, char **argv) {
 	g_free(card_name);
 #endif
 	if (NULL == dev) {
-		dev = gmp_dev_list_get_playback_default(&app.dev_list);
+		dev = gmp_dev_set_get_playback_default(&app.dev_set);
 	}
 	gtk_mixer_window_dev_cur_set(app.window, dev);
 
 
 	/* Tray icon. */
 	app.status_icon = gtk_mixer_tray_icon_create(app.window);
+	gtk_mixer_window_status_icon_set(app.window, app.status_icon);
 	g_signal_connect(app.status_icon, "activate",
 	    G_CALLBACK(gtk_mixer_status_icon_activate), &app);
 	g_signal_connect(app.status_icon, "popup-menu",
@@ -296,15 +563,62 @@ main(int argc, char **argv) {
 		gtk_window_present(GTK_WINDOW(app.window));
 	}
 
+	/* Backend I/O workers, plugins without worker called directly. */
+	for (size_t i = 0; i < app.plugins_count; i ++) {
+		fd = gmp_worker_start(&app.plugins[i]);
+		if (-1 == fd)
+			continue;
+		app.worker_src_ids[i] = g_unix_fd_add(fd, G_IO_IN,
+		    gtk_mixer_worker_cb, &app);
+	}
+	/* Current device was selected before workers start. */
+	app.dev_events = gmp_worker_dev_attach(app.dev);
+	app.watchdog = g_source_new(&gtk_mixer_watchdog_funcs,
+	    sizeof(gm_watchdog_source_t));
+	((gm_watchdog_source_p)app.watchdog)->app = &app;
+	g_source_attach(app.watchdog, NULL);
+
+	/* Devices add/remove. */
+	app.hotplug_fd = gmp_hotplug_open(app.plugins, app.plugins_count);
+	if (-1 != app.hotplug_fd) {
+		app.hotplug_src_id = g_unix_fd_add(app.hotplug_fd, G_IO_IN,
+		    gtk_mixer_hotplug_cb, &app);
+	}
+
 	/* For update, if volume changed from other app. */
-	g_timeout_add(UPDATE_INTERVAL,
-	    (GSourceFunc)gtk_mixer_check_update, &app);
+	gtk_mixer_update_schedule(&app, 1);
 
 	gtk_main();
 
 	/* Cleanup. */
-	gmp_dev_list_clear(&app.dev_list);
+	if (0 != app.update_src_id) {
+		g_source_remove(app.update_src_id);
+	}
+	if (0 != app.hotplug_src_id) {
+		g_source_remove(app.hotplug_src_id);
+	}
+	g_source_destroy(app.watchdog);
+	g_source_unref(app.watchdog);
+	for (size_t i = 0; i < app.plugins_count; i ++) {
+		if (0 == app.worker_src_ids[i])
+			continue;
+		g_source_remove(app.worker_src_ids[i]);
+	}
+	gmp_hotplug_close(app.plugins, app.plugins_count, app.hotplug_fd);
+	/* Pending writes are done by workers, hung are not waited. */
+	gtk_mixer_watchdog(&app);
+	for (size_t i = 0; i < app.plugins_count; i ++) {
+		if (0 != gmp_worker_stop(&app.plugins[i])) {
+			hung ++;
+		}
+	}
+	/* Devices of hung plugin can not be destroyed. */
+	if (0 == hung) {
+		gmp_dev_set_clear(&app.dev_set);
+	}
+	/* Stop workers. */
 	gmp_uninit(app.plugins, app.plugins_count);
+	free(app.worker_src_ids);
 
 	return (error);
 }
@@ -68,21 +68,43 @@ gulong gtk_mixer_window_connect_dev_changed(GtkWidget *window,
     GCallback c_handler, gpointer data);
 gmp_dev_p gtk_mixer_window_dev_cur_get(GtkWidget *window);
 void gtk_mixer_window_dev_cur_set(GtkWidget *window, gmp_dev_p dev);
-void gtk_mixer_window_dev_list_update(GtkWidget *window, gmp_dev_list_p dev_list);
+/* Current device if it initialized and its controls shown, else NULL:
+ * init in progress. */
+gmp_dev_p gtk_mixer_window_dev_active_get(GtkWidget *window);
+/* Call on GMP_WORKER_RES_INIT. Return non zero if current device
+ * become active. */
+int gtk_mixer_window_dev_activate(GtkWidget *window);
+/* gmp_dev_set_update() events handler. */
+void gtk_mixer_window_dev_set_event(GtkWidget *window, gmp_dev_p dev,
+    const int event, const size_t idx);
+void gtk_mixer_window_dev_list_update(GtkWidget *window);
+void gtk_mixer_window_status_icon_set(GtkWidget *window,
+    GtkStatusIcon *status_icon);
+/* Schedule GUI update for lines changed since last update, once per
+ * frame. */
 void gtk_mixer_window_lines_update(GtkWidget *window);
+/* Schedule dev lines from write_mask write, once per frame. */
+void gtk_mixer_window_dev_write(GtkWidget *window, gmp_dev_p dev);
+void gtk_mixer_window_dev_write_flush(GtkWidget *window);
 
 GtkWidget *gtk_mixer_devs_combo_create(void);
 gmp_dev_p gtk_mixer_devs_combo_cur_get(GtkWidget *combo);
 void gtk_mixer_devs_combo_cur_set(GtkWidget *combo, gmp_dev_p dev);
-void gtk_mixer_devs_combo_dev_list_set(GtkWidget *combo, gmp_dev_list_p dev_list);
+void gtk_mixer_devs_combo_dev_add(GtkWidget *combo, gmp_dev_p dev,
+    const size_t pos);
+void gtk_mixer_devs_combo_dev_remove(GtkWidget *combo, gmp_dev_p dev);
+void gtk_mixer_devs_combo_dev_update(GtkWidget *combo, gmp_dev_p dev);
 void gtk_mixer_devs_combo_update(GtkWidget *combo);
 
 GtkWidget *gtk_mixer_container_create(void);
 void gtk_mixer_container_dev_set(GtkWidget *container, gmp_dev_p dev);
-void gtk_mixer_container_update(GtkWidget *container);
+void gtk_mixer_container_line_update(GtkWidget *container,
+    gmp_dev_line_p dev_line);
 
 GtkWidget *gtk_mixer_line_create(gmp_dev_p dev, gmp_dev_line_p dev_line);
 void gtk_mixer_line_update(GtkWidget *container);
+/* Icons loaded since start: cache misses, must not grow on redraw. */
+size_t gtk_mixer_line_icons_loads(void);
 
 
 GtkStatusIcon *gtk_mixer_tray_icon_create(GtkWidget *main_window);
@@ -54,10 +54,39 @@ static const uint8_t alsa_ch_map[] = {
 	MIXER_CHANNEL_LFE,	/* Woofer - SND_MIXER_SCHN_WOOFER */
 	MIXER_CHANNEL_SL,	/* Side Left - SND_MIXER_SCHN_SIDE_LEFT */
 	MIXER_CHANNEL_SR,	/* Side Right - SND_MIXER_SCHN_SIDE_RIGHT */
-	MIXER_CHANNEL_TBC	/* Rear Center - SND_MIXER_SCHN_REAR_CENTER */
+	MIXER_CHANNEL_TBC,	/* Rear Center - SND_MIXER_SCHN_REAR_CENTER */
+	/* Other channels up to SND_MIXER_SCHN_LAST does not have position. */
+	MIXER_CHANNEL_AUX0 + 0,
+	MIXER_CHANNEL_AUX0 + 1,
+	MIXER_CHANNEL_AUX0 + 2,
+	MIXER_CHANNEL_AUX0 + 3,
+	MIXER_CHANNEL_AUX0 + 4,
+	MIXER_CHANNEL_AUX0 + 5,
+	MIXER_CHANNEL_AUX0 + 6,
+	MIXER_CHANNEL_AUX0 + 7,
+	MIXER_CHANNEL_AUX0 + 8,
+	MIXER_CHANNEL_AUX0 + 9,
+	MIXER_CHANNEL_AUX0 + 10,
+	MIXER_CHANNEL_AUX0 + 11,
+	MIXER_CHANNEL_AUX0 + 12,
+	MIXER_CHANNEL_AUX0 + 13,
+	MIXER_CHANNEL_AUX0 + 14,
+	MIXER_CHANNEL_AUX0 + 15,
+	MIXER_CHANNEL_AUX0 + 16,
+	MIXER_CHANNEL_AUX0 + 17,
+	MIXER_CHANNEL_AUX0 + 18,
+	MIXER_CHANNEL_AUX0 + 19,
+	MIXER_CHANNEL_AUX0 + 20,
+	MIXER_CHANNEL_AUX0 + 21,
+	MIXER_CHANNEL_AUX0 + 22,
 };
 
 
+static const gmp_hotplug_node_t alsa_hotplug_nodes[] = {
+	{ .dir = "/dev/snd",	.prefix = "controlC" },
+	{ .dir = NULL,		.prefix = NULL }
+};
+
 static const char *ignored_device_list[] = {
 	"cards",
 	"center_lfe",
@@ -93,6 +122,40 @@ static const char *ignored_device_list[] = {
 };
 
 
+#define ALSA_CTL_ENGINE_ENVVAR	"ALSA_CTL_ENGINE_DEVS"
+#define ALSA_LIST_VIRTUAL_ENVVAR "ALSA_LIST_VIRTUAL"
+#define PATH_PROC_ASOUND_CARDS	"/proc/asound/cards"
+
+/* Mixer engines. */
+#define ALSA_ENGINE_SELEM	0 /* Simple mixer: snd_mixer_selem_*(). */
+#define ALSA_ENGINE_CTL		1 /* Control interface: snd_ctl_elem_*(). */
+
+typedef struct alsa_device_context_s {
+	int		engine; /* ALSA_ENGINE_* */
+	/* ALSA_ENGINE_SELEM. */
+	snd_mixer_t	*mixer; /* Opened on dev_init(), closed on dev_uninit(). */
+	/* ALSA_ENGINE_CTL. */
+	snd_ctl_t	*ctl; /* Opened on dev_init(), closed on dev_uninit(). */
+	snd_ctl_elem_value_t *value; /* Reused by all reads and writes. */
+	size_t		*numid_map; /* numid -> (line index + 1). */
+	size_t		numid_map_count;
+} alsa_dev_ctx_t, *alsa_dev_ctx_p;
+
+/* ALSA_ENGINE_CTL per line data. */
+typedef struct alsa_ctl_line_s {
+	unsigned int	index; /* Element index, same for volume and switch. */
+	unsigned int	vol_numid;
+	unsigned int	vol_count; /* Values count = channels count. */
+	long		vol_min;
+	long		vol_max;
+	unsigned int	sw_numid; /* 0 - no switch. */
+	unsigned int	sw_count;
+	/* Last read/written state: unchanged elements are not written. */
+	gmp_dev_line_state_t last;
+	int		is_last_valid;
+} alsa_ctl_line_t, *alsa_ctl_line_p;
+
+
 static int
 is_ignored_device(const char *name, const size_t name_size) {
 	size_t dev_name_size;
@@ -113,51 +176,118 @@ is_ignored_device(const char *name, const size_t name_size) {
 	return (0);
 }
 
+/* Devices listed in ALSA_CTL_ENGINE_DEVS env var (space separated,
+ * "*" - all devices) use control interface engine. */
 static int
-alsa_list_devs(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
-	int error = 0, dev_index = -1;
-	void **hints = NULL;
-	char *name = NULL, *desc = NULL, dev_path[32];
-	gmp_dev_t dev = { .name = dev_path };
-	snd_ctl_t *ctl = NULL;
-	snd_ctl_card_info_t *info = NULL;
+alsa_dev_engine_get(const char *name) {
+	size_t name_size, tok_size;
+	const char *cur = getenv(ALSA_CTL_ENGINE_ENVVAR);
 
-	if (NULL == plugin || NULL == dev_list)
-		return (EINVAL);
+	if (NULL == cur)
+		return (ALSA_ENGINE_SELEM);
+	name_size = strlen(name);
+	for (;;) {
+		cur += strspn(cur, " \t");
+		tok_size = strcspn(cur, " \t");
+		if (0 == tok_size)
+			break;
+		if ((1 == tok_size && '*' == cur[0]) ||
+		    (name_size == tok_size &&
+		     0 == memcmp(cur, name, name_size)))
+			return (ALSA_ENGINE_CTL);
+		cur += tok_size;
+	}
 
-	if (0 != snd_ctl_card_info_malloc(&info))
-		return (ENOMEM);
+	return (ALSA_ENGINE_SELEM);
+}
 
-	/* Auto detect. */
-	/* Physical sound cards. */
-	while (0 == snd_card_next(&dev_index) && -1 != dev_index) {
-		snprintf(dev_path, sizeof(dev_path), "hw:%i", dev_index);
-		if (0 > snd_ctl_open(&ctl, dev_path, 0))
+/* Device context is allocated on first dev_init(), so devices list
+ * does not allocate per device. */
+static int
+alsa_list_dev_add(gm_plugin_p plugin, gmp_dev_list_p dev_list,
+    const char *name, const char *description) {
+	gmp_dev_t dev = { .name = name, .description = description };
+
+	return (gmp_dev_list_add(plugin, dev_list, &dev));
+}
+
+/* Physical sound cards from /proc/asound/cards, does not open any
+ * device. Each card described by 2 lines:
+ *  0 [PCH            ]: HDA-Intel - HDA Intel PCH
+ *                       HDA Intel PCH at 0xf7f10000 irq 32
+ */
+static int
+alsa_list_cards_procfs(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+	int error = 0;
+	long card;
+	FILE *fp;
+	char buf[512], *cur, *end, dev_path[32];
+
+	fp = fopen(PATH_PROC_ASOUND_CARDS, "r");
+	if (NULL == fp)
+		return (errno);
+	while (NULL != fgets(buf, sizeof(buf), fp)) {
+		cur = (buf + strspn(buf, " "));
+		card = strtol(cur, &end, 10);
+		if (cur == end || ' ' != end[0] || '[' != end[1])
+			continue; /* Not card first line. */
+		/* Description: after "]: " and driver name. */
+		cur = strstr(end, "]: ");
+		if (NULL == cur)
 			continue;
-		snd_ctl_card_info_clear(info);
-		error = snd_ctl_card_info(ctl, info);
-		snd_ctl_close(ctl);
+		cur += 3;
+		end = strstr(cur, " - ");
+		if (NULL != end) {
+			cur = (end + 3);
+		}
+		cur[strcspn(cur, "\r\n")] = 0x00;
+		snprintf(dev_path, sizeof(dev_path), "hw:%li", card);
+		error = alsa_list_dev_add(plugin, dev_list, dev_path, cur);
 		if (0 != error)
+			break;
+	}
+	fclose(fp);
+
+	return (error);
+}
+
+/* Physical sound cards, fallback if procfs is not available. */
+static int
+alsa_list_cards(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+	int error = 0, dev_index = -1;
+	char *desc, dev_path[32];
+
+	while (0 == snd_card_next(&dev_index) && -1 != dev_index) {
+		if (0 > snd_card_get_name(dev_index, &desc))
 			continue;
-		dev.description = snd_ctl_card_info_get_name(info);
-		//snd_ctl_card_info_get_longname(info);
-		//snd_ctl_card_info_get_mixername(info);
-		//snd_ctl_card_info_get_components(info);
-		dev.priv = strdup(dev.name);
-		error = gmp_dev_list_add(plugin, dev_list, &dev);
-		if (0 != error) {
-			free(dev.priv);
-			goto err_out;
-		}
+		snprintf(dev_path, sizeof(dev_path), "hw:%i", dev_index);
+		error = alsa_list_dev_add(plugin, dev_list, dev_path, desc);
+		free(desc);
+		if (0 != error)
+			break;
 	}
 
-	/* Virtual sound cards. */
+	return (error);
+}
+
+/* Virtual sound cards: parse whole ALSA config, slow. */
+static int
+alsa_list_virtual(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+	int error = 0;
+	void **hints = NULL;
+	char *name = NULL, *desc = NULL;
+	snd_ctl_t *ctl = NULL;
+	snd_ctl_card_info_t *info = NULL;
+
+	if (0 != snd_ctl_card_info_malloc(&info))
+		return (ENOMEM);
 	if (0 > snd_device_name_hint(-1, "pcm", &hints))
 		goto err_out;
 	for (size_t i = 0; NULL != hints[i]; i ++) {
 		free(name);
 		name = snd_device_name_get_hint(hints[i], "NAME");
-		if (is_ignored_device(name, strlen(name)))
+		if (NULL == name ||
+		    is_ignored_device(name, strlen(name)))
 			continue;
 		free(desc);
 		desc = snd_device_name_get_hint(hints[i], "DESC");
@@ -171,46 +301,109 @@ alsa_list_devs(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
 				continue;
 			desc = strdup(snd_ctl_card_info_get_name(info));
 		}
-		dev.name = name;
-		dev.description = desc;
-		dev.priv = strdup(dev.name);
-		error = gmp_dev_list_add(plugin, dev_list, &dev);
-		if (0 != error) {
-			free(dev.priv);
+		error = alsa_list_dev_add(plugin, dev_list, name, desc);
+		if (0 != error)
 			goto err_out;
-		}
 	}
 	error = 0;
 
 err_out:
 	free(name);
 	free(desc);
-	snd_device_name_free_hint(hints);
+	if (NULL != hints) {
+		snd_device_name_free_hint(hints);
+	}
 	snd_ctl_card_info_free(info);
 
 	return (error);
 }
 
 static int
-alsa_dev_init(gmp_dev_p dev) {
+alsa_list_devs(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+	int error;
+	const char *virt;
+
+	if (NULL == plugin || NULL == dev_list)
+		return (EINVAL);
+
+	/* Physical sound cards. */
+	error = alsa_list_cards_procfs(plugin, dev_list);
+	if (ENOENT == error || EACCES == error) {
+		error = alsa_list_cards(plugin, dev_list);
+	}
+	if (0 != error)
+		return (error);
+
+	/* Virtual sound cards: only on user request. */
+	virt = getenv(ALSA_LIST_VIRTUAL_ENVVAR);
+	if (NULL == virt || 0 == virt[0] || '0' == virt[0])
+		return (0);
+
+	return (alsa_list_virtual(plugin, dev_list));
+}
+
+static inline int
+alsa_vol_to_app(const long vol, const long vol_min, const long vol_max) {
+
+	if (vol_max <= vol_min || vol <= vol_min)
+		return (0);
+	if (vol >= vol_max)
+		return (100);
+	return ((int)((((vol - vol_min) * 100) + ((vol_max - vol_min) / 2)) /
+	    (vol_max - vol_min)));
+}
+
+static inline long
+alsa_vol_from_app(const int vol, const long vol_min, const long vol_max) {
+
+	if (vol_max <= vol_min)
+		return (vol_min);
+	return (vol_min + ((((vol_max - vol_min) * vol) + 50) / 100));
+}
+
+static int
+alsa_selem_elem_cb(snd_mixer_elem_t *elem, unsigned int mask) {
+	gmp_dev_line_p dev_line;
+
+	dev_line = snd_mixer_elem_get_callback_private(elem);
+	if (NULL == dev_line)
+		return (0);
+	/* All bits set: must be checked before others.
+	 * Element is freed after return, line without element is
+	 * gone: skipped by read and write. */
+	if (SND_CTL_EVENT_MASK_REMOVE == mask) {
+		snd_mixer_elem_set_callback_private(elem, NULL);
+		dev_line->priv = NULL;
+		return (0);
+	}
+	if (0 == (SND_CTL_EVENT_MASK_VALUE & mask))
+		return (0);
+	gmp_dev_line_read_required(dev_line);
+
+	return (0);
+}
+
+static int
+alsa_selem_dev_init(gmp_dev_p dev) {
 	int error = 0;
 	gmp_dev_line_p dev_line;
-	snd_mixer_t *mixer = NULL;
+	alsa_dev_ctx_p dev_ctx;
 	snd_mixer_elem_t *elem;
 
-	if (NULL == dev)
+	if (NULL == dev || NULL == dev->priv)
 		return (EINVAL);
 
-	if (0 > snd_mixer_open(&mixer, 0))
+	dev_ctx = dev->priv;
+	if (0 > snd_mixer_open(&dev_ctx->mixer, 0))
 		return (EINVAL);
-	if (0 > snd_mixer_attach(mixer, dev->priv))
-		goto err_out;
-	if (0 > snd_mixer_selem_register(mixer, NULL, NULL))
-		goto err_out;
-	if (0 > snd_mixer_load(mixer))
+	if (0 > snd_mixer_attach(dev_ctx->mixer, dev->name) ||
+	    0 > snd_mixer_selem_register(dev_ctx->mixer, NULL, NULL) ||
+	    0 > snd_mixer_load(dev_ctx->mixer)) {
+		error = ENODEV;
 		goto err_out;
+	}
 
-	for (elem = snd_mixer_first_elem(mixer); NULL != elem;
+	for (elem = snd_mixer_first_elem(dev_ctx->mixer); NULL != elem;
 	     elem = snd_mixer_elem_next(elem)) {
 		if (0 == snd_mixer_selem_is_active(elem))
 			continue;
@@ -222,25 +415,642 @@ alsa_dev_init(gmp_dev_p dev) {
 		    &dev_line);
 		if (0 != error)
 			goto err_out;
-		dev_line->priv = (void*)snd_mixer_selem_get_index(elem); /* Store line index. */
+		dev_line->priv = elem; /* Store mixer element. */
 		for (int i = 0; i < (int)nitems(alsa_ch_map); i ++) {
 			if (0 == snd_mixer_selem_has_playback_channel(elem, i) &&
 			    0 == snd_mixer_selem_has_capture_channel(elem, i))
 				continue;
-			dev_line->chan_map |= (((uint32_t)1) << alsa_ch_map[i]);
+			dev_line->chan_map |= (((uint64_t)1) << alsa_ch_map[i]);
 			dev_line->chan_vol_count ++;
 		}
 		dev_line->is_capture = (0 != snd_mixer_selem_has_capture_volume(elem));
 		dev_line->is_read_only = 0;
-		dev_line->has_enable = snd_mixer_selem_has_playback_switch(elem);
+		if (dev_line->is_capture) {
+			dev_line->has_enable = snd_mixer_selem_has_capture_switch(elem);
+		} else {
+			dev_line->has_enable = snd_mixer_selem_has_playback_switch(elem);
+		}
 	}
 
+	/* Lines array is final now: bind elements to lines for events. */
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		dev_line = gmp_dev_line_get(dev, i);
+		snd_mixer_elem_set_callback_private(dev_line->priv, dev_line);
+		snd_mixer_elem_set_callback(dev_line->priv, alsa_selem_elem_cb);
+	}
+
+	return (0);
+
 err_out:
-	snd_mixer_close(mixer);
+	snd_mixer_close(dev_ctx->mixer);
+	dev_ctx->mixer = NULL;
 
 	return (error);
 }
 
+static int
+alsa_selem_line_read(gmp_dev_p dev, gmp_dev_line_p dev_line,
+    gmp_dev_line_state_p line_state) {
+	int rc, sw, sw_read = 0;
+	long vol, vol_min, vol_max;
+	snd_mixer_elem_t *elem;
+
+	if (NULL == dev || NULL == dev_line || NULL == line_state)
+		return (EINVAL);
+
+	elem = dev_line->priv;
+	if (NULL == elem)
+		return (0); /* Element removed. */
+	if (dev_line->is_capture) {
+		rc = snd_mixer_selem_get_capture_volume_range(elem,
+		    &vol_min, &vol_max);
+	} else {
+		rc = snd_mixer_selem_get_playback_volume_range(elem,
+		    &vol_min, &vol_max);
+	}
+	if (0 > rc)
+		return (EIO);
+
+	for (size_t i = 0; i < nitems(alsa_ch_map); i ++) {
+		if (0 == ((((uint64_t)1) << alsa_ch_map[i]) & dev_line->chan_map))
+			continue;
+		/* Volume level. */
+		if (dev_line->is_capture) {
+			rc = snd_mixer_selem_get_capture_volume(elem,
+			    (snd_mixer_selem_channel_id_t)i, &vol);
+		} else {
+			rc = snd_mixer_selem_get_playback_volume(elem,
+			    (snd_mixer_selem_channel_id_t)i, &vol);
+		}
+		if (0 > rc)
+			return (EIO);
+		line_state->chan_vol[gmp_dev_line_chan_idx(dev_line,
+		    alsa_ch_map[i])] = alsa_vol_to_app(vol, vol_min, vol_max);
+		/* Enabled state: line enabled if any channel is on. */
+		if (0 == dev_line->has_enable)
+			continue;
+		if (dev_line->is_capture) {
+			rc = snd_mixer_selem_get_capture_switch(elem,
+			    (snd_mixer_selem_channel_id_t)i, &sw);
+		} else {
+			rc = snd_mixer_selem_get_playback_switch(elem,
+			    (snd_mixer_selem_channel_id_t)i, &sw);
+		}
+		if (0 > rc)
+			return (EIO);
+		sw_read |= sw;
+	}
+	if (0 != dev_line->has_enable) {
+		line_state->is_enabled = (0 != sw_read);
+	}
+
+	return (0);
+}
+
+static int
+alsa_selem_line_write(gmp_dev_p dev, gmp_dev_line_p dev_line,
+    gmp_dev_line_state_p line_state) {
+	int rc;
+	long vol_min, vol_max;
+	snd_mixer_elem_t *elem;
+
+	if (NULL == dev || NULL == dev_line || NULL == line_state)
+		return (EINVAL);
+
+	elem = dev_line->priv;
+	if (NULL == elem)
+		return (0); /* Element removed. */
+	if (dev_line->is_capture) {
+		rc = snd_mixer_selem_get_capture_volume_range(elem,
+		    &vol_min, &vol_max);
+	} else {
+		rc = snd_mixer_selem_get_playback_volume_range(elem,
+		    &vol_min, &vol_max);
+	}
+	if (0 > rc)
+		return (EIO);
+
+	/* Volume level. */
+	for (size_t i = 0; i < nitems(alsa_ch_map); i ++) {
+		if (0 == ((((uint64_t)1) << alsa_ch_map[i]) & dev_line->chan_map))
+			continue;
+		if (dev_line->is_capture) {
+			rc = snd_mixer_selem_set_capture_volume(elem,
+			    (snd_mixer_selem_channel_id_t)i,
+			    alsa_vol_from_app(line_state->chan_vol[
+			    gmp_dev_line_chan_idx(dev_line, alsa_ch_map[i])],
+			    vol_min, vol_max));
+		} else {
+			rc = snd_mixer_selem_set_playback_volume(elem,
+			    (snd_mixer_selem_channel_id_t)i,
+			    alsa_vol_from_app(line_state->chan_vol[
+			    gmp_dev_line_chan_idx(dev_line, alsa_ch_map[i])],
+			    vol_min, vol_max));
+		}
+		if (0 > rc)
+			return (EIO);
+	}
+	/* Enabled state. */
+	if (0 != dev_line->has_enable) {
+		if (dev_line->is_capture) {
+			rc = snd_mixer_selem_set_capture_switch_all(elem,
+			    (0 != line_state->is_enabled));
+		} else {
+			rc = snd_mixer_selem_set_playback_switch_all(elem,
+			    (0 != line_state->is_enabled));
+		}
+		if (0 > rc)
+			return (EIO);
+	}
+
+	return (0);
+}
+
+static const char *alsa_ctl_vol_suffix[] = {
+	" Playback Volume",
+	" Capture Volume",
+	" Volume",
+};
+static const char *alsa_ctl_sw_suffix[] = {
+	" Playback Switch",
+	" Capture Switch",
+	" Switch",
+};
+
+/* Return suffix index in suffixes or -1 if name does not end with any. */
+static int
+alsa_ctl_name_suffix(const char *name, const char **suffixes,
+    const size_t suffixes_count, size_t *base_size) {
+	size_t name_size, suffix_size;
+
+	name_size = strlen(name);
+	for (size_t i = 0; i < suffixes_count; i ++) {
+		suffix_size = strlen(suffixes[i]);
+		if (name_size <= suffix_size)
+			continue;
+		if (0 != memcmp(&name[(name_size - suffix_size)], suffixes[i],
+		    suffix_size))
+			continue;
+		(*base_size) = (name_size - suffix_size);
+		return ((int)i);
+	}
+
+	return (-1);
+}
+
+/* Line key: base name, element index and direction. FNV-1a. */
+static size_t
+alsa_ctl_line_hash(const char *name, const size_t name_size,
+    const unsigned int index, const int is_capture) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	const uint8_t *ptr = (const uint8_t*)name;
+
+	for (size_t i = 0; i < name_size; i ++) {
+		hash ^= ptr[i];
+		hash *= 0x00000100000001b3ull;
+	}
+	hash ^= ((((uint64_t)index) << 1) | (0 != is_capture));
+	hash *= 0x00000100000001b3ull;
+
+	return ((size_t)hash);
+}
+
+/* Open addressing: line idx + 1, 0 - empty. */
+static size_t *
+alsa_ctl_lines_index(gmp_dev_p dev, size_t *index_size) {
+	size_t *index, idx, mask, size = 16;
+	gmp_dev_line_p dev_line;
+
+	while (size < (dev->lines_count * 2)) {
+		size *= 2;
+	}
+	index = calloc(size, sizeof(size_t));
+	if (NULL == index)
+		return (NULL);
+	mask = (size - 1);
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		dev_line = gmp_dev_line_get(dev, i);
+		for (idx = (alsa_ctl_line_hash(dev_line->display_name,
+		    strlen(dev_line->display_name),
+		    ((alsa_ctl_line_p)dev_line->priv)->index,
+		    dev_line->is_capture) & mask);
+		    0 != index[idx];
+		    idx = ((idx + 1) & mask))
+			;
+		index[idx] = (i + 1);
+	}
+	(*index_size) = size;
+
+	return (index);
+}
+
+/* First line with key that does not have switch yet. */
+static gmp_dev_line_p
+alsa_ctl_lines_index_find(gmp_dev_p dev, const size_t *index,
+    const size_t index_size, const char *name, const size_t name_size,
+    const unsigned int elem_index, const int is_capture) {
+	const size_t mask = (index_size - 1);
+	gmp_dev_line_p dev_line;
+	alsa_ctl_line_p ctl_line;
+
+	for (size_t idx = (alsa_ctl_line_hash(name, name_size, elem_index,
+	    is_capture) & mask);
+	    0 != index[idx];
+	    idx = ((idx + 1) & mask)) {
+		dev_line = gmp_dev_line_get(dev, (index[idx] - 1));
+		ctl_line = dev_line->priv;
+		if (0 != ctl_line->sw_numid ||
+		    ctl_line->index != elem_index ||
+		    is_capture != dev_line->is_capture ||
+		    0 != strncmp(name, dev_line->display_name, name_size) ||
+		    0 != dev_line->display_name[name_size])
+			continue;
+		return (dev_line);
+	}
+
+	return (NULL);
+}
+
+static gmp_dev_line_p
+alsa_ctl_numid_line(gmp_dev_p dev, const unsigned int numid) {
+	alsa_dev_ctx_p dev_ctx = dev->priv;
+
+	if (numid >= dev_ctx->numid_map_count ||
+	    0 == dev_ctx->numid_map[numid])
+		return (NULL);
+	return (gmp_dev_line_get(dev, (dev_ctx->numid_map[numid] - 1)));
+}
+
+static int
+alsa_ctl_dev_init(gmp_dev_p dev) {
+	int error = 0, suffix, is_capture;
+	unsigned int count, numid, numid_max = 0;
+	size_t base_size, *lines_index = NULL, lines_index_size = 0;
+	char line_name[256];
+	const char *name;
+	gmp_dev_line_p dev_line;
+	alsa_dev_ctx_p dev_ctx;
+	alsa_ctl_line_p ctl_line;
+	snd_ctl_elem_list_t *list = NULL;
+	snd_ctl_elem_info_t *info = NULL;
+
+	dev_ctx = dev->priv;
+	if (0 > snd_ctl_open(&dev_ctx->ctl, dev->name, 0))
+		return (ENODEV);
+	if (0 != snd_ctl_elem_list_malloc(&list) ||
+	    0 != snd_ctl_elem_info_malloc(&info) ||
+	    0 != snd_ctl_elem_value_malloc(&dev_ctx->value)) {
+		error = ENOMEM;
+		goto err_out;
+	}
+	/* Get all elements ids in one call. */
+	if (0 > snd_ctl_elem_list(dev_ctx->ctl, list)) {
+		error = EIO;
+		goto err_out;
+	}
+	count = snd_ctl_elem_list_get_count(list);
+	if (0 > snd_ctl_elem_list_alloc_space(list, count)) {
+		error = ENOMEM;
+		goto err_out;
+	}
+	if (0 > snd_ctl_elem_list(dev_ctx->ctl, list)) {
+		error = EIO;
+		goto err_out;
+	}
+
+	/* Volumes: one line per volume element. */
+	for (unsigned int i = 0; i < count; i ++) {
+		if (SND_CTL_ELEM_IFACE_MIXER !=
+		    snd_ctl_elem_list_get_interface(list, i))
+			continue;
+		name = snd_ctl_elem_list_get_name(list, i);
+		suffix = alsa_ctl_name_suffix(name, alsa_ctl_vol_suffix,
+		    nitems(alsa_ctl_vol_suffix), &base_size);
+		if (0 > suffix)
+			continue;
+		numid = snd_ctl_elem_list_get_numid(list, i);
+		snd_ctl_elem_info_clear(info);
+		snd_ctl_elem_info_set_numid(info, numid);
+		if (0 > snd_ctl_elem_info(dev_ctx->ctl, info))
+			continue;
+		if (SND_CTL_ELEM_TYPE_INTEGER != snd_ctl_elem_info_get_type(info) ||
+		    0 == snd_ctl_elem_info_is_readable(info) ||
+		    0 != snd_ctl_elem_info_is_inactive(info))
+			continue;
+		ctl_line = calloc(1, sizeof(alsa_ctl_line_t));
+		if (NULL == ctl_line) {
+			error = ENOMEM;
+			goto err_out;
+		}
+		ctl_line->index = snd_ctl_elem_info_get_index(info);
+		ctl_line->vol_numid = numid;
+		ctl_line->vol_count = snd_ctl_elem_info_get_count(info);
+		ctl_line->vol_min = snd_ctl_elem_info_get_min(info);
+		ctl_line->vol_max = snd_ctl_elem_info_get_max(info);
+		/* Add line. */
+		is_capture = (1 == suffix ||
+		    NULL != strstr(name, "Capture"));
+		snprintf(line_name, sizeof(line_name), "%.*s",
+		    (int)base_size, name);
+		error = gmp_dev_line_add(dev, line_name, &dev_line);
+		if (0 != error) {
+			free(ctl_line);
+			goto err_out;
+		}
+		dev_line->priv = ctl_line;
+		for (unsigned int ch = 0; ch < ctl_line->vol_count &&
+		    ch < nitems(alsa_ch_map); ch ++) {
+			dev_line->chan_map |= (((uint64_t)1) << alsa_ch_map[ch]);
+			dev_line->chan_vol_count ++;
+		}
+		dev_line->is_capture = is_capture;
+		dev_line->is_read_only = (0 == snd_ctl_elem_info_is_writable(info));
+		numid_max = MAX(numid_max, numid);
+	}
+
+	/* Switches: bind to line with same base name, direction and index. */
+	lines_index = alsa_ctl_lines_index(dev, &lines_index_size);
+	if (NULL == lines_index) {
+		error = ENOMEM;
+		goto err_out;
+	}
+	for (unsigned int i = 0; i < count; i ++) {
+		if (SND_CTL_ELEM_IFACE_MIXER !=
+		    snd_ctl_elem_list_get_interface(list, i))
+			continue;
+		name = snd_ctl_elem_list_get_name(list, i);
+		suffix = alsa_ctl_name_suffix(name, alsa_ctl_sw_suffix,
+		    nitems(alsa_ctl_sw_suffix), &base_size);
+		if (0 > suffix)
+			continue;
+		is_capture = (1 == suffix ||
+		    NULL != strstr(name, "Capture"));
+		dev_line = alsa_ctl_lines_index_find(dev, lines_index,
+		    lines_index_size, name, base_size,
+		    snd_ctl_elem_list_get_index(list, i), is_capture);
+		if (NULL == dev_line)
+			continue;
+		numid = snd_ctl_elem_list_get_numid(list, i);
+		snd_ctl_elem_info_clear(info);
+		snd_ctl_elem_info_set_numid(info, numid);
+		if (0 > snd_ctl_elem_info(dev_ctx->ctl, info))
+			continue;
+		if (SND_CTL_ELEM_TYPE_BOOLEAN != snd_ctl_elem_info_get_type(info))
+			continue;
+		ctl_line = dev_line->priv;
+		ctl_line->sw_numid = numid;
+		ctl_line->sw_count = snd_ctl_elem_info_get_count(info);
+		dev_line->has_enable = 1;
+		numid_max = MAX(numid_max, numid);
+	}
+	free(lines_index);
+	lines_index = NULL;
+
+	/* numid -> line map for events. */
+	dev_ctx->numid_map_count = ((size_t)numid_max + 1);
+	dev_ctx->numid_map = calloc(dev_ctx->numid_map_count, sizeof(size_t));
+	if (NULL == dev_ctx->numid_map) {
+		error = ENOMEM;
+		goto err_out;
+	}
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		ctl_line = gmp_dev_line_get(dev, i)->priv;
+		dev_ctx->numid_map[ctl_line->vol_numid] = (i + 1);
+		if (0 != ctl_line->sw_numid) {
+			dev_ctx->numid_map[ctl_line->sw_numid] = (i + 1);
+		}
+	}
+	/* Not fatal on error: lines will be polled by timer. */
+	snd_ctl_subscribe_events(dev_ctx->ctl, 1);
+
+	snd_ctl_elem_info_free(info);
+	snd_ctl_elem_list_free_space(list);
+	snd_ctl_elem_list_free(list);
+
+	return (0);
+
+err_out:
+	free(lines_index);
+	if (NULL != info) {
+		snd_ctl_elem_info_free(info);
+	}
+	if (NULL != list) {
+		snd_ctl_elem_list_free_space(list);
+		snd_ctl_elem_list_free(list);
+	}
+
+	return (error);
+}
+
+static void
+alsa_ctl_dev_uninit(gmp_dev_p dev) {
+	alsa_dev_ctx_p dev_ctx = dev->priv;
+
+	if (NULL != dev_ctx->ctl) {
+		snd_ctl_close(dev_ctx->ctl);
+		dev_ctx->ctl = NULL;
+	}
+	if (NULL != dev_ctx->value) {
+		snd_ctl_elem_value_free(dev_ctx->value);
+		dev_ctx->value = NULL;
+	}
+	free(dev_ctx->numid_map);
+	dev_ctx->numid_map = NULL;
+	dev_ctx->numid_map_count = 0;
+}
+
+static int
+alsa_ctl_line_read(gmp_dev_p dev, gmp_dev_line_p dev_line,
+    gmp_dev_line_state_p line_state) {
+	int sw_read = 0;
+	alsa_dev_ctx_p dev_ctx = dev->priv;
+	alsa_ctl_line_p ctl_line = dev_line->priv;
+
+	if (NULL == dev_ctx->ctl)
+		return (EINVAL);
+	if (NULL == ctl_line)
+		return (0); /* Element removed. */
+
+	ctl_line->is_last_valid = 0;
+	/* Volume level. */
+	snd_ctl_elem_value_clear(dev_ctx->value);
+	snd_ctl_elem_value_set_numid(dev_ctx->value, ctl_line->vol_numid);
+	if (0 > snd_ctl_elem_read(dev_ctx->ctl, dev_ctx->value))
+		return (EIO);
+	for (unsigned int ch = 0; ch < ctl_line->vol_count &&
+	    ch < nitems(alsa_ch_map); ch ++) {
+		line_state->chan_vol[gmp_dev_line_chan_idx(dev_line,
+		    alsa_ch_map[ch])] = alsa_vol_to_app(
+		    snd_ctl_elem_value_get_integer(dev_ctx->value, ch),
+		    ctl_line->vol_min, ctl_line->vol_max);
+	}
+	/* Enabled state: line enabled if any channel is on. */
+	if (0 != ctl_line->sw_numid) {
+		snd_ctl_elem_value_clear(dev_ctx->value);
+		snd_ctl_elem_value_set_numid(dev_ctx->value,
+		    ctl_line->sw_numid);
+		if (0 > snd_ctl_elem_read(dev_ctx->ctl, dev_ctx->value))
+			return (EIO);
+		for (unsigned int ch = 0; ch < ctl_line->sw_count; ch ++) {
+			sw_read |= snd_ctl_elem_value_get_boolean(
+			    dev_ctx->value, ch);
+		}
+		line_state->is_enabled = (0 != sw_read);
+	}
+	memcpy(&ctl_line->last, line_state, sizeof(gmp_dev_line_state_t));
+	ctl_line->is_last_valid = 1;
+
+	return (0);
+}
+
+static int
+alsa_ctl_line_write(gmp_dev_p dev, gmp_dev_line_p dev_line,
+    gmp_dev_line_state_p line_state) {
+	int vol_changed, sw_changed;
+	alsa_dev_ctx_p dev_ctx = dev->priv;
+	alsa_ctl_line_p ctl_line = dev_line->priv;
+
+	if (NULL == dev_ctx->ctl)
+		return (EINVAL);
+	if (NULL == ctl_line)
+		return (0); /* Element removed. */
+
+	/* Only elements that changed since last read/write: volume or
+	 * mute change cost one ioctl. */
+	vol_changed = (0 == ctl_line->is_last_valid ||
+	    0 != memcmp(ctl_line->last.chan_vol, line_state->chan_vol,
+	    (dev_line->chan_vol_count * sizeof(int))));
+	sw_changed = (0 != ctl_line->sw_numid &&
+	    (0 == ctl_line->is_last_valid ||
+	    (0 != ctl_line->last.is_enabled) !=
+	    (0 != line_state->is_enabled)));
+	ctl_line->is_last_valid = 0;
+	/* Volume level. */
+	if (0 != vol_changed) {
+		snd_ctl_elem_value_clear(dev_ctx->value);
+		snd_ctl_elem_value_set_numid(dev_ctx->value,
+		    ctl_line->vol_numid);
+		for (unsigned int ch = 0; ch < ctl_line->vol_count; ch ++) {
+			snd_ctl_elem_value_set_integer(dev_ctx->value, ch,
+			    alsa_vol_from_app(line_state->chan_vol[
+			    gmp_dev_line_chan_idx(dev_line,
+			    alsa_ch_map[MIN(ch, (nitems(alsa_ch_map) - 1))])],
+			    ctl_line->vol_min, ctl_line->vol_max));
+		}
+		if (0 > snd_ctl_elem_write(dev_ctx->ctl, dev_ctx->value))
+			return (EIO);
+	}
+	/* Enabled state. */
+	if (0 != sw_changed) {
+		snd_ctl_elem_value_clear(dev_ctx->value);
+		snd_ctl_elem_value_set_numid(dev_ctx->value,
+		    ctl_line->sw_numid);
+		for (unsigned int ch = 0; ch < ctl_line->sw_count; ch ++) {
+			snd_ctl_elem_value_set_boolean(dev_ctx->value, ch,
+			    (0 != line_state->is_enabled));
+		}
+		if (0 > snd_ctl_elem_write(dev_ctx->ctl, dev_ctx->value))
+			return (EIO);
+	}
+	memcpy(&ctl_line->last, line_state, sizeof(gmp_dev_line_state_t));
+	ctl_line->is_last_valid = 1;
+
+	return (0);
+}
+
+/* Element removed: line without volume element is gone, skipped by
+ * read and write. */
+static void
+alsa_ctl_elem_remove(gmp_dev_p dev, gmp_dev_line_p dev_line,
+    const unsigned int numid) {
+	alsa_dev_ctx_p dev_ctx = dev->priv;
+	alsa_ctl_line_p ctl_line = dev_line->priv;
+
+	dev_ctx->numid_map[numid] = 0;
+	if (numid == ctl_line->sw_numid) {
+		ctl_line->sw_numid = 0;
+		return;
+	}
+	if (0 != ctl_line->sw_numid) {
+		dev_ctx->numid_map[ctl_line->sw_numid] = 0;
+	}
+	dev_line->priv = NULL;
+	free(ctl_line);
+}
+
+static int
+alsa_ctl_handle_events(gmp_dev_p dev) {
+	int rc;
+	unsigned int mask, numid;
+	gmp_dev_line_p dev_line;
+	alsa_dev_ctx_p dev_ctx = dev->priv;
+	snd_ctl_event_t *event;
+
+	snd_ctl_event_alloca(&event);
+	while (0 < (rc = snd_ctl_read(dev_ctx->ctl, event))) {
+		if (SND_CTL_EVENT_ELEM != snd_ctl_event_get_type(event))
+			continue;
+		numid = snd_ctl_event_elem_get_numid(event);
+		dev_line = alsa_ctl_numid_line(dev, numid);
+		if (NULL == dev_line)
+			continue;
+		mask = snd_ctl_event_elem_get_mask(event);
+		/* All bits set: must be checked before others. */
+		if (SND_CTL_EVENT_MASK_REMOVE == mask) {
+			alsa_ctl_elem_remove(dev, dev_line, numid);
+			continue;
+		}
+		if (0 == (SND_CTL_EVENT_MASK_VALUE & mask))
+			continue;
+		((alsa_ctl_line_p)dev_line->priv)->is_last_valid = 0;
+		gmp_dev_line_read_required(dev_line);
+	}
+	if (0 > rc && -EAGAIN != rc)
+		return (EIO);
+
+	return (0);
+}
+
+
+static int
+alsa_dev_init(gmp_dev_p dev) {
+	alsa_dev_ctx_p dev_ctx;
+
+	if (NULL == dev)
+		return (EINVAL);
+	/* Kept until dev_destroy(): dev_line_destroy() need it. */
+	if (NULL == dev->priv) {
+		dev->priv = calloc(1, sizeof(alsa_dev_ctx_t));
+		if (NULL == dev->priv)
+			return (ENOMEM);
+	}
+
+	dev_ctx = dev->priv;
+	/* Lines of previous init are destroyed: engine can be changed. */
+	dev_ctx->engine = alsa_dev_engine_get(dev->name);
+	if (ALSA_ENGINE_CTL == dev_ctx->engine)
+		return (alsa_ctl_dev_init(dev));
+	return (alsa_selem_dev_init(dev));
+}
+
+static void
+alsa_dev_uninit(gmp_dev_p dev) {
+	alsa_dev_ctx_p dev_ctx;
+
+	if (NULL == dev || NULL == dev->priv)
+		return;
+
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_CTL == dev_ctx->engine) {
+		alsa_ctl_dev_uninit(dev);
+		return;
+	}
+	if (NULL == dev_ctx->mixer)
+		return;
+	snd_mixer_close(dev_ctx->mixer);
+	dev_ctx->mixer = NULL;
+}
+
 static void
 alsa_dev_destroy(gmp_dev_p dev) {
 
@@ -251,35 +1061,213 @@ alsa_dev_destroy(gmp_dev_p dev) {
 	dev->priv = NULL;
 }
 
+static void
+alsa_dev_line_destroy(gmp_dev_p dev, gmp_dev_line_p dev_line) {
+	alsa_dev_ctx_p dev_ctx;
+
+	if (NULL == dev || NULL == dev->priv || NULL == dev_line)
+		return;
+
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_CTL == dev_ctx->engine) {
+		free(dev_line->priv);
+	}
+	/* ALSA_ENGINE_SELEM: element is owned by mixer. */
+	dev_line->priv = NULL;
+}
+
+
+static int
+alsa_dev_poll_descriptors(gmp_dev_p dev, struct pollfd *pfds,
+    size_t pfds_count) {
+	int cnt;
+	alsa_dev_ctx_p dev_ctx;
+
+	if (NULL == dev || NULL == dev->priv)
+		return (0);
+
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_CTL == dev_ctx->engine) {
+		if (NULL == dev_ctx->ctl)
+			return (0);
+		cnt = snd_ctl_poll_descriptors_count(dev_ctx->ctl);
+		if (0 >= cnt)
+			return (0);
+		if (NULL == pfds || (size_t)cnt > pfds_count)
+			return (cnt);
+		cnt = snd_ctl_poll_descriptors(dev_ctx->ctl, pfds,
+		    (unsigned int)cnt);
+		return (MAX(0, cnt));
+	}
+	if (NULL == dev_ctx->mixer)
+		return (0);
+	cnt = snd_mixer_poll_descriptors_count(dev_ctx->mixer);
+	if (0 >= cnt)
+		return (0);
+	if (NULL == pfds || (size_t)cnt > pfds_count)
+		return (cnt);
+	cnt = snd_mixer_poll_descriptors(dev_ctx->mixer, pfds,
+	    (unsigned int)cnt);
+
+	return (MAX(0, cnt));
+}
+
+static int
+alsa_dev_handle_events(gmp_dev_p dev, struct pollfd *pfds,
+    size_t pfds_count) {
+	int rc;
+	unsigned short revents = 0;
+	alsa_dev_ctx_p dev_ctx;
+
+	if (NULL == dev || NULL == dev->priv)
+		return (EINVAL);
+
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_CTL == dev_ctx->engine) {
+		if (NULL == dev_ctx->ctl)
+			return (EINVAL);
+		rc = snd_ctl_poll_descriptors_revents(dev_ctx->ctl, pfds,
+		    (unsigned int)pfds_count, &revents);
+	} else {
+		if (NULL == dev_ctx->mixer)
+			return (EINVAL);
+		rc = snd_mixer_poll_descriptors_revents(dev_ctx->mixer, pfds,
+		    (unsigned int)pfds_count, &revents);
+	}
+	if (0 > rc)
+		return (EINVAL);
+	if (0 != ((POLLERR | POLLHUP | POLLNVAL) & revents))
+		return (ENODEV); /* Device disconnected. */
+	if (ALSA_ENGINE_CTL == dev_ctx->engine)
+		return (alsa_ctl_handle_events(dev));
+	if (0 > snd_mixer_handle_events(dev_ctx->mixer))
+		return (EIO);
+
+	return (0);
+}
+
 
 static int
 alsa_dev_line_read(gmp_dev_p dev, gmp_dev_line_p dev_line,
     gmp_dev_line_state_p line_state) {
-	int error = 0;
+	alsa_dev_ctx_p dev_ctx;
 
-	if (NULL == dev || NULL == dev_line || NULL == line_state)
+	if (NULL == dev || NULL == dev->priv ||
+	    NULL == dev_line || NULL == line_state)
 		return (EINVAL);
 
-	return (error);
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_CTL == dev_ctx->engine)
+		return (alsa_ctl_line_read(dev, dev_line, line_state));
+	return (alsa_selem_line_read(dev, dev_line, line_state));
 }
 
 static int
 alsa_dev_line_write(gmp_dev_p dev, gmp_dev_line_p dev_line,
     gmp_dev_line_state_p line_state) {
-	int error = 0;
+	alsa_dev_ctx_p dev_ctx;
 
-	if (NULL == dev || NULL == dev_line || NULL == line_state)
+	if (NULL == dev || NULL == dev->priv ||
+	    NULL == dev_line || NULL == line_state)
 		return (EINVAL);
 
-	return (error);
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_CTL == dev_ctx->engine)
+		return (alsa_ctl_line_write(dev, dev_line, line_state));
+	return (alsa_selem_line_write(dev, dev_line, line_state));
+}
+
+static int
+alsa_dev_read_all(gmp_dev_p dev, const size_t *lines_mask,
+    gmp_dev_line_state_p line_states) {
+	int error;
+	alsa_dev_ctx_p dev_ctx;
+	gmp_dev_line_p dev_line;
+
+	if (NULL == dev || NULL == dev->priv || NULL == lines_mask ||
+	    NULL == line_states)
+		return (EINVAL);
+
+	dev_ctx = dev->priv;
+	if (ALSA_ENGINE_SELEM == dev_ctx->engine) {
+		if (NULL == dev_ctx->mixer)
+			return (EINVAL);
+		/* Simple mixer keep elements values cached:
+		 * apply pending changes once for all lines. */
+		if (0 > snd_mixer_handle_events(dev_ctx->mixer))
+			return (EIO);
+	}
+	/* Control interface does not have multi elements read:
+	 * one ioctl per element, by numid stored on init. */
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		if (0 == GMP_LINES_MASK_IS_SET(lines_mask, i))
+			continue;
+		dev_line = gmp_dev_line_get(dev, i);
+		if (ALSA_ENGINE_CTL == dev_ctx->engine) {
+			error = alsa_ctl_line_read(dev, dev_line,
+			    &line_states[i]);
+		} else {
+			error = alsa_selem_line_read(dev, dev_line,
+			    &line_states[i]);
+		}
+		if (0 != error)
+			return (error);
+	}
+
+	return (0);
+}
+
+static int
+alsa_dev_write_batch(gmp_dev_p dev, const size_t *lines_mask,
+    gmp_dev_line_state_p line_states) {
+	int error;
+	alsa_dev_ctx_p dev_ctx;
+	gmp_dev_line_p dev_line;
+
+	if (NULL == dev || NULL == dev->priv || NULL == lines_mask ||
+	    NULL == line_states)
+		return (EINVAL);
+
+	dev_ctx = dev->priv;
+	if ((ALSA_ENGINE_CTL == dev_ctx->engine && NULL == dev_ctx->ctl) ||
+	    (ALSA_ENGINE_SELEM == dev_ctx->engine && NULL == dev_ctx->mixer))
+		return (EINVAL);
+	/* Both engines write only elements with changed values:
+	 * simple mixer compare with cached, control interface with
+	 * last read/written. */
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		if (0 == GMP_LINES_MASK_IS_SET(lines_mask, i))
+			continue;
+		dev_line = gmp_dev_line_get(dev, i);
+		if (ALSA_ENGINE_CTL == dev_ctx->engine) {
+			error = alsa_ctl_line_write(dev, dev_line,
+			    &line_states[i]);
+		} else {
+			error = alsa_selem_line_write(dev, dev_line,
+			    &line_states[i]);
+		}
+		if (0 != error)
+			return (error);
+	}
+
+	return (0);
 }
 
 const gmp_descr_t plugin_alsa = {
 	.name		= "ALSA",
 	.description	= "ALSA Mixer driver plugin",
 	.list_devs	= alsa_list_devs,
+	.hotplug_nodes	= alsa_hotplug_nodes,
+	.notify		= (GMP_NOTIFY_LINES | GMP_NOTIFY_DEVS | GMP_NOTIFY_DEF_DEV),
+	.poll_cost	= GMP_POLL_COST_MEDIUM,
 	.dev_init	= alsa_dev_init,
+	.dev_uninit	= alsa_dev_uninit,
 	.dev_destroy	= alsa_dev_destroy,
+	.dev_line_destroy= alsa_dev_line_destroy,
 	.dev_line_read	= alsa_dev_line_read,
 	.dev_line_write	= alsa_dev_line_write,
+	.dev_read_all	= alsa_dev_read_all,
+	.dev_write_batch= alsa_dev_write_batch,
+	.dev_poll_descriptors = alsa_dev_poll_descriptors,
+	.dev_handle_events = alsa_dev_handle_events,
 };
@@ -30,6 +30,10 @@
 
 #include <sys/param.h>
 #include <sys/types.h>
+#ifdef __linux__
+#	include <sys/inotify.h>
+#	define HAVE_INOTIFY 1
+#endif
 #include <inttypes.h>
 #include <errno.h>
 #include <stdio.h>
@@ -53,6 +57,154 @@ strcmp_safe(const char *s1, const char *s2) {
 	return (strcmp(s1, s2));
 }
 
+/* FNV-1a 64 bit. */
+#define GMP_FNV_OFFSET		0xcbf29ce484222325ull
+#define GMP_FNV_PRIME		0x00000100000001b3ull
+
+static inline uint64_t
+gmp_fnv1a(uint64_t hash, const void *data, const size_t data_size) {
+	const uint8_t *ptr = data;
+
+	for (size_t i = 0; i < data_size; i ++) {
+		hash ^= ptr[i];
+		hash *= GMP_FNV_PRIME;
+	}
+
+	return (hash);
+}
+
+/* Return index of first set bit >= idx or lines_count. */
+static inline size_t
+gmp_lines_mask_next(const size_t *mask, const size_t lines_count,
+    size_t idx) {
+	size_t word;
+
+	while (idx < lines_count) {
+		word = (mask[(idx / GMP_LINES_MASK_BITS)] >>
+		    (idx % GMP_LINES_MASK_BITS));
+		if (0 != word)
+			return (MIN(lines_count,
+			    (idx + (size_t)__builtin_ctzll(word))));
+		/* Skip to next word. */
+		idx = ((idx / GMP_LINES_MASK_BITS) + 1) * GMP_LINES_MASK_BITS;
+	}
+
+	return (lines_count);
+}
+
+/* Devices list initial size. */
+#define GMP_DEV_LIST_ALLOC_MIN	16
+
+/* Strings pool: interned strings are bump allocated in chunks and
+ * indexed by open addressing hash table, never freed until plugin
+ * uninit. Used under plugin lock. */
+#define GMP_STR_POOL_CHUNK_SIZE	4096
+#define GMP_STR_POOL_TBL_MIN	32
+
+typedef struct gmp_str_chunk_s *gmp_str_chunk_p;
+typedef struct gmp_str_chunk_s {
+	gmp_str_chunk_p	next;
+	size_t		used;
+	size_t		size;
+	char		data[];
+} gmp_str_chunk_t;
+
+typedef struct gtk_mixer_plugin_str_pool_s {
+	gmp_str_chunk_p	chunks; /* Current chunk first. */
+	const char	**tbl;
+	size_t		tbl_size; /* Power of 2. */
+	size_t		count;
+} gmp_str_pool_t;
+
+static void
+gmp_str_pool_destroy(gmp_str_pool_p pool) {
+	gmp_str_chunk_p chunk;
+
+	if (NULL == pool)
+		return;
+	while (NULL != pool->chunks) {
+		chunk = pool->chunks;
+		pool->chunks = chunk->next;
+		free(chunk);
+	}
+	free(pool->tbl);
+	free(pool);
+}
+
+static int
+gmp_str_pool_tbl_grow(gmp_str_pool_p pool) {
+	size_t tbl_size, idx;
+	const char **tbl;
+
+	tbl_size = MAX(GMP_STR_POOL_TBL_MIN, (pool->tbl_size * 2));
+	tbl = calloc(tbl_size, sizeof(const char*));
+	if (NULL == tbl)
+		return (ENOMEM);
+	for (size_t i = 0; i < pool->tbl_size; i ++) {
+		if (NULL == pool->tbl[i])
+			continue;
+		idx = (size_t)gmp_fnv1a(GMP_FNV_OFFSET, pool->tbl[i],
+		    strlen(pool->tbl[i]));
+		for (idx &= (tbl_size - 1); NULL != tbl[idx];
+		    idx = ((idx + 1) & (tbl_size - 1)))
+			;
+		tbl[idx] = pool->tbl[i];
+	}
+	free(pool->tbl);
+	pool->tbl = tbl;
+	pool->tbl_size = tbl_size;
+
+	return (0);
+}
+
+static const char *
+gmp_str_intern(gm_plugin_p plugin, const char *str) {
+	size_t str_size, idx, mask;
+	char *ret;
+	gmp_str_pool_p pool = plugin->str_pool;
+	gmp_str_chunk_p chunk;
+
+	if (NULL == pool) {
+		pool = calloc(1, sizeof(gmp_str_pool_t));
+		if (NULL == pool)
+			return (NULL);
+		plugin->str_pool = pool;
+	}
+	/* Keep load factor <= 1/2. */
+	if ((pool->count * 2) >= pool->tbl_size &&
+	    0 != gmp_str_pool_tbl_grow(pool))
+		return (NULL);
+
+	str_size = strlen(str);
+	mask = (pool->tbl_size - 1);
+	for (idx = ((size_t)gmp_fnv1a(GMP_FNV_OFFSET, str, str_size) & mask);
+	    NULL != pool->tbl[idx];
+	    idx = ((idx + 1) & mask)) {
+		if (0 == strcmp(pool->tbl[idx], str))
+			return (pool->tbl[idx]);
+	}
+	/* Not found: add. */
+	str_size ++;
+	chunk = pool->chunks;
+	if (NULL == chunk || (chunk->size - chunk->used) < str_size) {
+		chunk = malloc(sizeof(gmp_str_chunk_t) +
+		    MAX(GMP_STR_POOL_CHUNK_SIZE, str_size));
+		if (NULL == chunk)
+			return (NULL);
+		chunk->next = pool->chunks;
+		chunk->used = 0;
+		chunk->size = MAX(GMP_STR_POOL_CHUNK_SIZE, str_size);
+		pool->chunks = chunk;
+	}
+	ret = &chunk->data[chunk->used];
+	memcpy(ret, str, str_size);
+	chunk->used += str_size;
+	pool->tbl[idx] = ret;
+	pool->count ++;
+
+	return (ret);
+}
+
 static inline int
 volume_apply_limits(const int vol) {
 
@@ -63,17 +215,109 @@ volume_apply_limits(const int vol) {
 	return (vol);
 }
 
-static void
-gmp_dev_line_state_vol_normalize(gmp_dev_line_state_p state,
-    const uint32_t chan_map) {
+/* Channels volumes vectors: packed chan_vol[] with count items.
+ * Branchless loops without early exit, compiler can vectorize them. */
+static inline void
+gmp_vol_clamp(int *vol, const size_t count) {
 
-	if (NULL == state || 0 == chan_map)
-		return;
-	for (size_t i = 0; i < MIXER_CHANNELS_COUNT; i ++) {
-		if (0 == (((((uint32_t)1) << i) & chan_map)))
+	for (size_t i = 0; i < count; i ++) {
+		vol[i] = MIN(100, MAX(0, vol[i]));
+	}
+}
+
+static inline int
+gmp_vol_max(const int *vol, const size_t count) {
+	int ret = 0;
+
+	for (size_t i = 0; i < count; i ++) {
+		ret = MAX(ret, vol[i]);
+	}
+
+	return (ret);
+}
+
+static inline void
+gmp_vol_fill(int *vol, const size_t count, const int val) {
+
+	for (size_t i = 0; i < count; i ++) {
+		vol[i] = val;
+	}
+}
+
+static inline void
+gmp_vol_add(int *vol, const size_t count, const int val) {
+
+	for (size_t i = 0; i < count; i ++) {
+		vol[i] = MIN(100, MAX(0, (vol[i] + val)));
+	}
+}
+
+static inline int
+gmp_vol_is_equal(const int *vol1, const int *vol2, const size_t count) {
+	int diff = 0;
+
+	for (size_t i = 0; i < count; i ++) {
+		diff |= (vol1[i] ^ vol2[i]);
+	}
+
+	return (0 == diff);
+}
+
+static inline int
+gmp_vol_is_zero(const int *vol, const size_t count) {
+	int bits = 0;
+
+	for (size_t i = 0; i < count; i ++) {
+		bits |= vol[i];
+	}
+
+	return (0 == bits);
+}
+
+
+/* Call list_devs() and update plugin fingerprints.
+ * Return 1 if devices list changed. If list_update = 0 then list change
+ * is not stored, to be reported later by gmp_is_list_devs_changed(). */
+static int
+gmp_plugin_fp_update(gm_plugin_p plugin, const int list_update) {
+	int ret, is_def;
+	uint64_t fp_list = GMP_FNV_OFFSET, fp_def = GMP_FNV_OFFSET;
+	gmp_dev_p dev;
+	gmp_dev_list_t dev_list;
+
+	memset(&dev_list, 0x00, sizeof(dev_list));
+	if (0 != plugin->descr->list_devs(plugin, &dev_list)) {
+		gmp_dev_list_clear(&dev_list);
+		return (0); /* Keep current list. */
+	}
+	for (size_t i = 0; i < dev_list.count; i ++) {
+		dev = &dev_list.devs[i];
+		/* Include 0x00 to separate strings. */
+		fp_list = gmp_fnv1a(fp_list, dev->name,
+		    (strlen(dev->name) + 1));
+		fp_list = gmp_fnv1a(fp_list, dev->description,
+		    (strlen(dev->description) + 1));
+		if (NULL == plugin->descr->dev_is_default)
 			continue;
-		state->chan_vol[i] = volume_apply_limits(state->chan_vol[i]);
+		is_def = plugin->descr->dev_is_default(dev);
+		fp_def = gmp_fnv1a(fp_def, &is_def, sizeof(is_def));
 	}
+	gmp_dev_list_clear(&dev_list);
+
+	ret = (plugin->fp_list != fp_list);
+	if (0 != ret && 0 == list_update)
+		return (ret);
+	if (0 != ret) {
+		/* New list will have actual defaults. */
+		plugin->fp_def_changed = 0;
+	} else if (plugin->fp_def != fp_def) {
+		plugin->fp_def_changed = 1;
+	}
+	plugin->fp_list = fp_list;
+	plugin->fp_def = fp_def;
+	plugin->fp_updated = 1;
+
+	return (ret);
 }
 
 
@@ -102,6 +346,11 @@ gmp_init(gm_plugin_p *plugins, size_t *plugins_count) {
 				plugin->descr->is_list_devs_changed(plugin);
 			}
 		}
+		if (NULL == plugin->descr->is_list_devs_changed ||
+		    (NULL == plugin->descr->is_def_dev_changed &&
+		     NULL != plugin->descr->dev_is_default)) {
+			gmp_plugin_fp_update(plugin, 1);
+		}
 		j ++;
 	}
 	(*plugins_count) = j;
@@ -111,6 +360,7 @@ gmp_init(gm_plugin_p *plugins, size_t *plugins_count) {
 
 void
 gmp_uninit(gm_plugin_p plugins, const size_t plugins_count) {
+	size_t hung = 0;
 	gm_plugin_p plugin;
 
 	if (NULL == plugins || 0 == plugins_count)
@@ -118,34 +368,74 @@ gmp_uninit(gm_plugin_p plugins, const size_t plugins_count) {
 
 	for (size_t i = 0; i < plugins_count; i ++) {
 		plugin = &plugins[i];
-		if (NULL == plugin->descr->uninit)
+		if (0 != gmp_worker_stop(plugin)) {
+			/* Worker hung in plugin call: plugin left as is. */
+			hung ++;
 			continue;
-		plugin->descr->uninit(plugin);
+		}
+		/* Scanned list not applied. */
+		gmp_dev_list_clear(plugin->dev_list);
+		free(plugin->dev_list);
+		plugin->dev_list = NULL;
+		if (NULL != plugin->descr->uninit) {
+			plugin->descr->uninit(plugin);
+		}
+		gmp_str_pool_destroy(plugin->str_pool);
+		plugin->str_pool = NULL;
+	}
+	if (0 == hung) {
+		free(plugins);
 	}
-	free(plugins);
 }
 
 
+int
+gmp_plugin_is_def_dev_changed(gm_plugin_p plugin) {
+	int ret = 0;
+
+	if (NULL == plugin)
+		return (0);
+
+	gmp_plugin_lock(plugin);
+	if (NULL != plugin->descr->is_def_dev_changed) {
+		ret = (0 != plugin->descr->is_def_dev_changed(plugin));
+	} else if (NULL != plugin->descr->dev_is_default) {
+		/* Compare default devices fingerprint, it may be
+		 * already updated by gmp_is_list_devs_changed(). */
+		if (0 == plugin->fp_updated &&
+		    0 != gmp_plugin_fp_update(plugin, 0)) {
+			ret = 1; /* List changed: defaults too. */
+		} else {
+			plugin->fp_updated = 0;
+			ret = plugin->fp_def_changed;
+			plugin->fp_def_changed = 0;
+		}
+	}
+	gmp_plugin_unlock(plugin);
+
+	return (ret);
+}
+
 int
 gmp_is_def_dev_changed(gm_plugin_p plugins, const size_t plugins_count) {
+	int ret = 0;
 	gm_plugin_p plugin;
 
 	if (NULL == plugins || 0 == plugins_count)
 		return (0);
 
+	/* Consume changes flags from all plugins. */
 	for (size_t i = 0; i < plugins_count; i ++) {
 		plugin = &plugins[i];
-		/* TODO: if sound backend does not support
-		 * is_def_dev_changed() but support dev_is_default()
-		 * then we must call list_devs() and compare resuls with
-		 * cached devices list to detect changes. */
-		if (NULL == plugin->descr->is_def_dev_changed)
+		if (NULL != plugin->worker) { /* Checked by worker. */
+			ret |= plugin->worker_def_changed;
+			plugin->worker_def_changed = 0;
 			continue;
-		if (0 != plugin->descr->is_def_dev_changed(plugin))
-			return (1);
+		}
+		ret |= gmp_plugin_is_def_dev_changed(plugin);
 	}
 
-	return (0);
+	return (ret);
 }
 
 
@@ -154,9 +444,8 @@ gmp_is_def_dev_separate(gm_plugin_p plugin) {
 
 	if (NULL == plugin)
 		return (0);
-	if (NULL == plugin->descr->is_def_dev_separate)
-		return (0);
-	return (plugin->descr->is_def_dev_separate(plugin));
+
+	return (plugin->def_dev_separate);
 }
 
 
@@ -164,7 +453,6 @@ int
 gmp_list_devs(gm_plugin_p plugins, const size_t plugins_count,
     gmp_dev_list_p dev_list) {
 	int error;
-	gm_plugin_p plugin;
 
 	if (NULL == plugins || NULL == dev_list)
 		return (EINVAL);
@@ -172,60 +460,76 @@ gmp_list_devs(gm_plugin_p plugins, const size_t plugins_count,
 		return (ENODEV);
 
 	for (size_t i = 0; i < plugins_count; i ++) {
-		plugin = &plugins[i];
-		error = plugin->descr->list_devs(plugin, dev_list);
+		error = gmp_plugin_list_devs(&plugins[i], dev_list);
 		if (0 != error) {
 			gmp_dev_list_clear(dev_list);
 			return (error);
 		}
+		plugins[i].def_dev_separate = dev_list->def_dev_separate;
 	}
 
 	return (0);
 }
 
-void
-gmp_dev_list_clear(gmp_dev_list_p dev_list) {
-	gmp_dev_p dev;
+int
+gmp_plugin_list_devs(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+	int error;
+	size_t count;
 
-	if (NULL == dev_list)
-		return;
+	if (NULL == plugin || NULL == dev_list)
+		return (EINVAL);
 
-	for (size_t i = 0; i < dev_list->count; i ++) {
-		dev = &dev_list->devs[i];
-		gmp_dev_uninit(dev);
-		if (NULL != dev->plugin->descr->dev_destroy) {
-			dev->plugin->descr->dev_destroy(dev);
-		}
-		free((void*)dev->description);
-		free((void*)dev->name);
+	count = dev_list->count;
+	gmp_plugin_lock(plugin);
+	error = plugin->descr->list_devs(plugin, dev_list);
+	/* Defaults are cached: GUI must not wait for plugin. */
+	for (size_t i = count; 0 == error &&
+	    NULL != plugin->descr->dev_is_default &&
+	    i < dev_list->count; i ++) {
+		dev_list->devs[i].def_flags =
+		    plugin->descr->dev_is_default(&dev_list->devs[i]);
 	}
-	dev_list->count = 0;
-	free(dev_list->devs);
+	dev_list->def_dev_separate = 0;
+	if (NULL != plugin->descr->is_def_dev_separate) {
+		dev_list->def_dev_separate =
+		    plugin->descr->is_def_dev_separate(plugin);
+	}
+	gmp_plugin_unlock(plugin);
+
+	return (error);
 }
 
-gmp_dev_p
-gmp_dev_find_same(gmp_dev_list_p dev_list, gmp_dev_p dev) {
-	gmp_dev_p cur_dev;
+void
+gmp_dev_destroy(gmp_dev_p dev) {
+
+	gmp_plugin_lock(dev->plugin);
+	gmp_dev_uninit(dev);
+	if (NULL != dev->plugin->descr->dev_destroy) {
+		dev->plugin->descr->dev_destroy(dev);
+	}
+	gmp_plugin_unlock(dev->plugin);
+	/* name and description are interned. */
+}
+
+void
+gmp_dev_list_clear(gmp_dev_list_p dev_list) {
 
 	if (NULL == dev_list)
-		return (NULL);
+		return;
 
 	for (size_t i = 0; i < dev_list->count; i ++) {
-		cur_dev = &dev_list->devs[i];
-		if (dev->plugin != cur_dev->plugin)
-			continue;
-		if (0 != strcmp_safe(dev->name, cur_dev->name) ||
-		    0 != strcmp_safe(dev->description, cur_dev->description))
-			continue;
-		return (cur_dev);
+		gmp_dev_destroy(&dev_list->devs[i]);
 	}
-
-	return (NULL);
+	free(dev_list->devs);
+	dev_list->devs = NULL;
+	dev_list->count = 0;
+	dev_list->allocated = 0;
 }
 
 int
 gmp_dev_list_add(gm_plugin_p plugin, gmp_dev_list_p dev_list,
     gmp_dev_p dev) {
+	size_t allocated;
 	gmp_dev_t gdd, *dev_new;
 
 	if (NULL == plugin || NULL == dev_list || NULL == dev)
@@ -239,15 +543,24 @@ gmp_dev_list_add(gm_plugin_p plugin, gmp_dev_list_p dev_list,
 		gdd.description = "";
 	}
 
-	dev_new = reallocarray(dev_list->devs,
-	    (dev_list->count + 2),
-	    sizeof(gmp_dev_t));
-	if (NULL == dev_new)
+	gdd.name = gmp_str_intern(plugin, gdd.name);
+	gdd.description = gmp_str_intern(plugin, gdd.description);
+	if (NULL == gdd.name || NULL == gdd.description)
 		return (ENOMEM);
-	dev_list->devs = dev_new;
+
+	if (dev_list->count == dev_list->allocated) {
+		allocated = MAX(GMP_DEV_LIST_ALLOC_MIN,
+		    (dev_list->allocated * 2));
+		dev_new = reallocarray(dev_list->devs, allocated,
+		    sizeof(gmp_dev_t));
+		if (NULL == dev_new)
+			return (ENOMEM);
+		dev_list->devs = dev_new;
+		dev_list->allocated = allocated;
+	}
 	memset(&dev_list->devs[dev_list->count], 0x00, sizeof(gmp_dev_t));
-	dev_list->devs[dev_list->count].name = strdup(gdd.name);
-	dev_list->devs[dev_list->count].description = strdup(gdd.description);
+	dev_list->devs[dev_list->count].name = gdd.name;
+	dev_list->devs[dev_list->count].description = gdd.description;
 	dev_list->devs[dev_list->count].plugin = plugin;
 	dev_list->devs[dev_list->count].priv = gdd.priv;
 	dev_list->count ++;
@@ -255,22 +568,264 @@ gmp_dev_list_add(gm_plugin_p plugin, gmp_dev_list_p dev_list,
 	return (0);
 }
 
+
+/* Devices set. */
+#define GMP_DEV_SET_INDEX_MIN	32
+
+static inline size_t
+gmp_dev_set_hash(gm_plugin_p plugin, const char *name) {
+	const uintptr_t key[2] = { (uintptr_t)plugin, (uintptr_t)name };
+
+	/* Names are interned: pointer identify string within plugin. */
+	return ((size_t)gmp_fnv1a(GMP_FNV_OFFSET, key, sizeof(key)));
+}
+
+static void
+gmp_dev_set_index_build(gmp_dev_set_p dev_set) {
+	size_t idx, mask = (dev_set->index_size - 1);
+	gmp_dev_p dev;
+
+	memset(dev_set->index, 0x00, (dev_set->index_size * sizeof(size_t)));
+	for (size_t i = 0; i < dev_set->count; i ++) {
+		dev = dev_set->devs[i];
+		for (idx = (gmp_dev_set_hash(dev->plugin, dev->name) & mask);
+		    0 != dev_set->index[idx]; idx = ((idx + 1) & mask))
+			;
+		dev_set->index[idx] = (i + 1);
+	}
+}
+
+/* Return old devs idx + 1 or 0. */
+static size_t
+gmp_dev_set_lookup(gmp_dev_set_p dev_set, gm_plugin_p plugin,
+    const char *name) {
+	size_t idx, mask;
+	gmp_dev_p dev;
+
+	if (0 == dev_set->index_size)
+		return (0);
+	mask = (dev_set->index_size - 1);
+	for (idx = (gmp_dev_set_hash(plugin, name) & mask);
+	    0 != dev_set->index[idx]; idx = ((idx + 1) & mask)) {
+		dev = dev_set->devs[(dev_set->index[idx] - 1)];
+		if (plugin == dev->plugin && name == dev->name)
+			return (dev_set->index[idx]);
+	}
+
+	return (0);
+}
+
+/* Merge plugin dev_list into dev_set, dev_list is consumed.
+ * Set is sorted by plugin: other plugins devices keep their order. */
+static int
+gmp_dev_set_update(gmp_dev_set_p dev_set, gm_plugin_p plugin,
+    gmp_dev_list_p dev_list, gmp_dev_set_cb cb, void *udata) {
+	int error;
+	size_t i, j, first, last, count, list_count, old_idx;
+	size_t index_size = GMP_DEV_SET_INDEX_MIN;
+	size_t *index = NULL;
+	uint8_t *old_seen = NULL, *new_event = NULL;
+	gmp_dev_p dev, *devs = NULL;
+	gmp_worker_trash_p trash = NULL;
+
+	/* Plugin devices: [first, last). */
+	for (first = 0; first < dev_set->count &&
+	    dev_set->devs[first]->plugin < plugin; first ++)
+		;
+	for (last = first; last < dev_set->count &&
+	    dev_set->devs[last]->plugin == plugin; last ++)
+		;
+	list_count = dev_list->count;
+	count = ((dev_set->count - (last - first)) + list_count);
+	while (index_size < (count * 2)) {
+		index_size *= 2;
+	}
+
+	/* Allocate all first: set is not changed on error. */
+	devs = calloc((count + 1), sizeof(gmp_dev_p));
+	old_seen = calloc((dev_set->count + list_count + 1),
+	    sizeof(uint8_t));
+	trash = gmp_worker_trash_alloc((last - first));
+	if (index_size != dev_set->index_size) {
+		index = calloc(index_size, sizeof(size_t));
+	} else {
+		index = dev_set->index;
+	}
+	if (NULL == devs || NULL == old_seen || NULL == trash ||
+	    NULL == index) {
+		error = ENOMEM;
+		goto err_out;
+	}
+	new_event = &old_seen[dev_set->count];
+	for (i = 0; i < list_count; i ++) {
+		dev = &dev_list->devs[i];
+		old_idx = gmp_dev_set_lookup(dev_set, dev->plugin, dev->name);
+		if (0 != old_idx &&
+		    0 == old_seen[(old_idx - 1)]) { /* Still present. */
+			old_seen[(old_idx - 1)] = 1;
+			devs[(first + i)] = dev_set->devs[(old_idx - 1)];
+			if (devs[(first + i)]->description !=
+			    dev->description ||
+			    devs[(first + i)]->def_flags != dev->def_flags) {
+				new_event[i] = GMP_DEV_SET_CHANGED;
+			}
+			continue;
+		}
+		devs[(first + i)] = malloc(sizeof(gmp_dev_t));
+		if (NULL == devs[(first + i)]) {
+			error = ENOMEM;
+			goto err_out;
+		}
+		new_event[i] = GMP_DEV_SET_ADDED;
+	}
+
+	/* Removed devices: report before destroy. */
+	for (i = first; i < last; i ++) {
+		if (0 != old_seen[i])
+			continue;
+		dev = dev_set->devs[i];
+		if (NULL != cb) {
+			cb(dev, GMP_DEV_SET_REMOVED, i, udata);
+		}
+		gmp_worker_dev_destroy(dev);
+		trash->devs[trash->devs_count ++] = dev;
+	}
+	/* Move new devices, left scan data of present devices. */
+	for (i = 0, j = 0; i < list_count; i ++) {
+		dev = &dev_list->devs[i];
+		if (GMP_DEV_SET_ADDED == new_event[i]) {
+			memcpy(devs[(first + i)], dev, sizeof(gmp_dev_t));
+			continue;
+		}
+		if (GMP_DEV_SET_CHANGED == new_event[i]) {
+			devs[(first + i)]->description = dev->description;
+			devs[(first + i)]->def_flags = dev->def_flags;
+		}
+		/* Not initialized: only list_devs() data. */
+		dev_list->devs[j ++] = (*dev);
+	}
+	dev_list->count = j;
+	/* Other plugins devices. */
+	memcpy(devs, dev_set->devs, (first * sizeof(gmp_dev_p)));
+	memcpy(&devs[(first + list_count)], &dev_set->devs[last],
+	    ((dev_set->count - last) * sizeof(gmp_dev_p)));
+	free(dev_set->devs);
+	if (index != dev_set->index) {
+		free(dev_set->index);
+	}
+	dev_set->devs = devs;
+	dev_set->count = count;
+	dev_set->index = index;
+	dev_set->index_size = index_size;
+	gmp_dev_set_index_build(dev_set);
+
+	if (NULL != cb) {
+		for (i = 0; i < list_count; i ++) {
+			if (0 == new_event[i])
+				continue;
+			cb(dev_set->devs[(first + i)], new_event[i],
+			    (first + i), udata);
+		}
+	}
+	free(old_seen);
+	/* GUI does not wait for plugin. */
+	trash->dev_list = dev_list;
+	gmp_worker_trash_put(plugin, trash);
+
+	return (0);
+
+err_out:
+	if (NULL != devs) {
+		for (i = 0; NULL != new_event && i < list_count; i ++) {
+			if (GMP_DEV_SET_ADDED != new_event[i])
+				continue;
+			free(devs[(first + i)]);
+		}
+		free(devs);
+	}
+	free(old_seen);
+	free(trash);
+	if (index != dev_set->index) {
+		free(index);
+	}
+	gmp_worker_dev_list_destroy(plugin, dev_list);
+
+	return (error);
+}
+
+size_t
+gmp_dev_set_apply(gmp_dev_set_p dev_set, gm_plugin_p plugins,
+    const size_t plugins_count, gmp_dev_set_cb cb, void *udata) {
+	size_t ret = 0;
+	gm_plugin_p plugin;
+	gmp_dev_list_p dev_list;
+
+	if (NULL == dev_set || NULL == plugins)
+		return (0);
+
+	for (size_t i = 0; i < plugins_count; i ++) {
+		plugin = &plugins[i];
+		dev_list = plugin->dev_list;
+		if (NULL == dev_list)
+			continue;
+		plugin->dev_list = NULL;
+		plugin->def_dev_separate = dev_list->def_dev_separate;
+		if (0 != gmp_dev_set_update(dev_set, plugin, dev_list,
+		    cb, udata))
+			continue;
+		ret ++;
+	}
+
+	return (ret);
+}
+
 gmp_dev_p
-gmp_dev_list_get_playback_default(gmp_dev_list_p dev_list) {
+gmp_dev_set_find(gmp_dev_set_p dev_set, gm_plugin_p plugin,
+    const char *name) {
+	size_t idx;
 
-	if (NULL == dev_list)
+	if (NULL == dev_set || NULL == plugin || NULL == name)
 		return (NULL);
-	for (size_t i = 0; i < dev_list->count; i ++) {
-		if (0 != (DEV_IS_PLAY & gmp_dev_is_default(&dev_list->devs[i])))
-			return (&dev_list->devs[i]);
+	idx = gmp_dev_set_lookup(dev_set, plugin, name);
+	if (0 == idx)
+		return (NULL);
+
+	return (dev_set->devs[(idx - 1)]);
+}
+
+gmp_dev_p
+gmp_dev_set_get_playback_default(gmp_dev_set_p dev_set) {
+
+	if (NULL == dev_set)
+		return (NULL);
+	for (size_t i = 0; i < dev_set->count; i ++) {
+		if (0 != (DEV_IS_PLAY & gmp_dev_is_default(dev_set->devs[i])))
+			return (dev_set->devs[i]);
 	}
 
 	return (NULL);
 }
 
+void
+gmp_dev_set_clear(gmp_dev_set_p dev_set) {
+
+	if (NULL == dev_set)
+		return;
+
+	for (size_t i = 0; i < dev_set->count; i ++) {
+		gmp_worker_dev_destroy(dev_set->devs[i]);
+		gmp_dev_destroy(dev_set->devs[i]);
+		free(dev_set->devs[i]);
+	}
+	free(dev_set->devs);
+	free(dev_set->index);
+	memset(dev_set, 0x00, sizeof(gmp_dev_set_t));
+}
+
 
 int
 gmp_is_list_devs_changed(gm_plugin_p plugins, const size_t plugins_count) {
+	int ret = 0;
 	gm_plugin_p plugin;
 
 	if (NULL == plugins || 0 == plugins_count)
@@ -278,34 +833,287 @@ gmp_is_list_devs_changed(gm_plugin_p plugins, const size_t plugins_count) {
 
 	for (size_t i = 0; i < plugins_count; i ++) {
 		plugin = &plugins[i];
-		/* TODO: if sound backend does not support
-		 * is_list_devs_changed() then we must call
-		 * list_devs() and compare resuls with
-		 * cached devices list to detect changes. */
-		if (NULL == plugin->descr->is_list_devs_changed)
+		/* Hotplug watcher report changes. */
+		if (0 != plugin->hotplug_watched ||
+		    0 != plugin->hotplug_changed) {
+			ret |= plugin->hotplug_changed;
+			plugin->hotplug_changed = 0;
+			continue;
+		}
+		if (NULL != plugin->worker) { /* Checked by worker. */
+			ret |= plugin->worker_list_changed;
+			plugin->worker_list_changed = 0;
 			continue;
-		if (0 != plugin->descr->is_list_devs_changed(plugin))
+		}
+		ret |= gmp_plugin_is_list_devs_changed(plugin);
+	}
+
+	return (ret);
+}
+
+int
+gmp_plugin_is_list_devs_changed(gm_plugin_p plugin) {
+	int ret;
+
+	if (NULL == plugin)
+		return (0);
+
+	gmp_plugin_lock(plugin);
+	if (NULL == plugin->descr->is_list_devs_changed) {
+		/* Compare devices list fingerprint. */
+		ret = gmp_plugin_fp_update(plugin, 1);
+	} else {
+		ret = (0 != plugin->descr->is_list_devs_changed(plugin));
+	}
+	gmp_plugin_unlock(plugin);
+
+	return (ret);
+}
+
+
+int
+gmp_plugin_is_poll_required(gm_plugin_p plugin) {
+
+	if (NULL == plugin)
+		return (0);
+	/* Devices add/remove. */
+	if (0 == (GMP_NOTIFY_DEVS & plugin->descr->notify) ||
+	    0 == plugin->hotplug_watched)
+		return (1);
+	/* Default device. */
+	if (0 == (GMP_NOTIFY_DEF_DEV & plugin->descr->notify) &&
+	    (NULL != plugin->descr->is_def_dev_changed ||
+	     NULL != plugin->descr->dev_is_default))
+		return (1);
+
+	return (0);
+}
+
+int
+gmp_is_poll_required(gm_plugin_p plugins, const size_t plugins_count) {
+
+	if (NULL == plugins)
+		return (0);
+
+	for (size_t i = 0; i < plugins_count; i ++) {
+		if (0 != gmp_plugin_is_poll_required(&plugins[i]))
 			return (1);
 	}
 
 	return (0);
 }
 
+int
+gmp_dev_is_poll_required(gmp_dev_p dev, const int is_events_attached) {
+
+	if (NULL == dev)
+		return (0);
+	if (0 == is_events_attached ||
+	    0 == (GMP_NOTIFY_LINES & dev->plugin->descr->notify))
+		return (1);
+
+	return (0);
+}
+
+uint32_t
+gmp_poll_cost(gm_plugin_p plugins, const size_t plugins_count) {
+	uint32_t ret = GMP_POLL_COST_LOW;
+
+	if (NULL == plugins)
+		return (ret);
+
+	for (size_t i = 0; i < plugins_count; i ++) {
+		ret = MAX(ret, plugins[i].descr->poll_cost);
+	}
+
+	return (ret);
+}
+
+
+int
+gmp_hotplug_open(gm_plugin_p plugins, const size_t plugins_count) {
+#ifdef HAVE_INOTIFY
+	int fd, watched = 0;
+	gm_plugin_p plugin;
+	const gmp_hotplug_node_t *node;
+
+	if (NULL == plugins || 0 == plugins_count)
+		return (-1);
+
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (-1 == fd)
+		return (-1);
+	for (size_t i = 0; i < plugins_count; i ++) {
+		plugin = &plugins[i];
+		plugin->hotplug_watched = 0;
+		if (NULL == plugin->descr->hotplug_nodes)
+			continue;
+		plugin->hotplug_watched = 1;
+		for (size_t j = 0; j < GMP_HOTPLUG_NODES_MAX; j ++) {
+			plugin->hotplug_wd[j] = -1;
+			node = &plugin->descr->hotplug_nodes[j];
+			if (NULL == node->dir)
+				break;
+			/* Same dir from other plugin return same wd. */
+			plugin->hotplug_wd[j] = inotify_add_watch(fd,
+			    node->dir, (IN_CREATE | IN_DELETE | IN_ATTRIB |
+			    IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR));
+			if (-1 == plugin->hotplug_wd[j]) {
+				/* Fallback to plugin change detection. */
+				plugin->hotplug_watched = 0;
+			}
+		}
+		watched += plugin->hotplug_watched;
+	}
+	if (0 == watched) {
+		close(fd);
+		return (-1);
+	}
+
+	return (fd);
+#else
+	(void)plugins;
+	(void)plugins_count;
+
+	return (-1);
+#endif
+}
+
+void
+gmp_hotplug_close(gm_plugin_p plugins, const size_t plugins_count,
+    int fd) {
+
+	if (-1 == fd)
+		return;
+	close(fd);
+	if (NULL == plugins)
+		return;
+	for (size_t i = 0; i < plugins_count; i ++) {
+		plugins[i].hotplug_watched = 0;
+	}
+}
+
+size_t
+gmp_hotplug_handle_events(gm_plugin_p plugins,
+    const size_t plugins_count, int fd) {
+	size_t ret = 0;
+#ifdef HAVE_INOTIFY
+	ssize_t rd;
+	gm_plugin_p plugin;
+	const gmp_hotplug_node_t *node;
+	const struct inotify_event *ev;
+	char buf[4096]
+	    __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	if (NULL == plugins || 0 == plugins_count || -1 == fd)
+		return (0);
+
+	while (0 < (rd = read(fd, buf, sizeof(buf)))) {
+		for (char *ptr = buf; ptr < (buf + rd);
+		    ptr += (sizeof(struct inotify_event) + ev->len)) {
+			ev = (const struct inotify_event*)(void*)ptr;
+			for (size_t i = 0; i < plugins_count; i ++) {
+				plugin = &plugins[i];
+				if (0 == plugin->hotplug_watched)
+					continue;
+				if (0 != (IN_Q_OVERFLOW & ev->mask)) {
+					plugin->hotplug_changed = 1;
+					continue;
+				}
+				for (size_t j = 0; j < GMP_HOTPLUG_NODES_MAX; j ++) {
+					node = &plugin->descr->hotplug_nodes[j];
+					if (NULL == node->dir)
+						break;
+					if (ev->wd != plugin->hotplug_wd[j])
+						continue;
+					if (0 != (IN_IGNORED & ev->mask)) {
+						/* Dir removed: fallback. */
+						plugin->hotplug_watched = 0;
+						plugin->hotplug_changed = 1;
+						break;
+					}
+					if (0 == ev->len ||
+					    0 != strncmp(ev->name, node->prefix,
+					    strlen(node->prefix)))
+						continue;
+					plugin->hotplug_changed = 1;
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < plugins_count; i ++) {
+		ret += (0 != plugins[i].hotplug_changed);
+	}
+#else
+	(void)plugins;
+	(void)plugins_count;
+	(void)fd;
+#endif
+
+	return (ret);
+}
+
 
 int
 gmp_dev_init(gmp_dev_p dev) {
 	int error;
+	size_t mask_count;
+	gmp_dev_line_p dev_line;
 
 	if (NULL == dev)
 		return (EINVAL);
 
+	gmp_plugin_lock(dev->plugin);
+	if (NULL != dev->read_mask) { /* Already initialized. */
+		atomic_store(&dev->init_state, GMP_DEV_INIT_DONE);
+		gmp_plugin_unlock(dev->plugin);
+		return (0);
+	}
 	if (NULL != dev->plugin->descr->dev_init) {
 		error = dev->plugin->descr->dev_init(dev);
 		if (0 != error)
-			return (error);
+			goto err_out;
+	}
+	/* Batch read/write buffers: own and for worker requests. */
+	dev->snapshot = gmp_dev_snapshot_alloc(dev);
+	dev->snap_read = gmp_dev_snapshot_alloc(dev);
+	dev->snap_write = gmp_dev_snapshot_alloc(dev);
+	dev->snap_events = gmp_dev_snapshot_alloc(dev);
+	if (NULL == dev->snapshot || NULL == dev->snap_read ||
+	    NULL == dev->snap_write || NULL == dev->snap_events) {
+		error = ENOMEM;
+		goto err_out;
+	}
+	/* Read and write masks. */
+	mask_count = (GMP_LINES_MASK_COUNT(dev->lines_count) + 1);
+	dev->read_mask = calloc((2 * mask_count), sizeof(size_t));
+	if (NULL == dev->read_mask) {
+		error = ENOMEM;
+		goto err_out;
 	}
+	dev->write_mask = &dev->read_mask[mask_count];
+	/* Packed channels volumes must fit to state. */
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		dev_line = gmp_dev_line_get(dev, i);
+		dev_line->chan_vol_count = (size_t)__builtin_popcountll(
+		    dev_line->chan_map);
+		if (GMPDL_CHAN_VOL_MAX < dev_line->chan_vol_count) {
+			error = EINVAL;
+			goto err_out;
+		}
+	}
+	atomic_store(&dev->init_state, GMP_DEV_INIT_DONE);
+	error = gmp_dev_read(dev, 1);
+	gmp_plugin_unlock(dev->plugin);
+
+	return (error);
 
-	return (gmp_dev_read(dev, 1));
+err_out:
+	/* Free lines that was added before error. */
+	gmp_dev_uninit(dev);
+	gmp_plugin_unlock(dev->plugin);
+
+	return (error);
 }
 
 void
@@ -315,165 +1123,413 @@ gmp_dev_uninit(gmp_dev_p dev) {
 	if (NULL == dev)
 		return;
 
+	gmp_plugin_lock(dev->plugin);
+	gmp_worker_dev_release(dev);
+	atomic_store(&dev->init_state, GMP_DEV_INIT_NONE);
 	if (NULL != dev->plugin->descr->dev_uninit) {
 		dev->plugin->descr->dev_uninit(dev);
 	}
 
-	if (NULL != dev->lines) {
-		for (size_t i = 0; i < dev->lines_count; i ++) {
-			dev_line = &dev->lines[i];
-			if (NULL != dev->plugin->descr->dev_line_destroy) {
-				dev->plugin->descr->dev_line_destroy(dev,
-				    dev_line);
-			}
-			free((void*)dev_line->display_name);
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		dev_line = gmp_dev_line_get(dev, i);
+		if (NULL != dev->plugin->descr->dev_line_destroy) {
+			dev->plugin->descr->dev_line_destroy(dev, dev_line);
 		}
-		free(dev->lines);
-		dev->lines = NULL;
+		free((void*)dev_line->display_name);
+	}
+	for (size_t i = 0; i < GMP_DEV_LINES_CHUNKS_MAX; i ++) {
+		free(dev->lines[i]);
+		dev->lines[i] = NULL;
 	}
 	dev->lines_count = 0;
+	dev->chg_head = NULL;
+	free(dev->snapshot);
+	dev->snapshot = NULL;
+	free(dev->snap_read);
+	dev->snap_read = NULL;
+	free(dev->snap_write);
+	dev->snap_write = NULL;
+	free(dev->snap_events);
+	dev->snap_events = NULL;
+	free(dev->read_mask);
+	dev->read_mask = NULL;
+	dev->write_mask = NULL;
+	gmp_plugin_unlock(dev->plugin);
 }
 
 
 int
 gmp_dev_is_default(gmp_dev_p dev) {
 
-	if (NULL == dev ||
-	    NULL == dev->plugin->descr->dev_is_default)
+	if (NULL == dev)
 		return (DEV_IS_UNSED);
-	return (dev->plugin->descr->dev_is_default(dev));
+
+	return (dev->def_flags);
 }
 
 int
 gmp_dev_set_default(gmp_dev_p dev, const uint32_t type) {
+	int error;
 
 	if (NULL == dev)
 		return (EINVAL);
 	if (NULL == dev->plugin->descr->dev_set_default)
 		return (0);
-	return (dev->plugin->descr->dev_set_default(dev, type));
+	gmp_plugin_lock(dev->plugin);
+	error = dev->plugin->descr->dev_set_default(dev, type);
+	gmp_plugin_unlock(dev->plugin);
+
+	return (error);
 }
 
 
+size_t
+gmp_dev_poll_descriptors(gmp_dev_p dev, struct pollfd *pfds,
+    size_t pfds_count) {
+	int rc;
+
+	if (NULL == dev ||
+	    NULL == dev->plugin->descr->dev_poll_descriptors)
+		return (0);
+	if (NULL == pfds) {
+		pfds_count = 0;
+	}
+	gmp_plugin_lock(dev->plugin);
+	rc = dev->plugin->descr->dev_poll_descriptors(dev, pfds, pfds_count);
+	gmp_plugin_unlock(dev->plugin);
+	if (0 >= rc)
+		return (0);
+
+	return ((size_t)rc);
+}
+
 int
-gmp_dev_read(gmp_dev_p dev, int force) {
+gmp_dev_handle_events(gmp_dev_p dev, struct pollfd *pfds,
+    size_t pfds_count) {
 	int error;
-	gmp_dev_line_p dev_line;
-	gmp_dev_line_state_t state_muted, state;
 
-	if (NULL == dev)
+	if (NULL == dev || NULL == pfds || 0 == pfds_count)
 		return (EINVAL);
+	if (NULL == dev->plugin->descr->dev_handle_events)
+		return (EOPNOTSUPP);
+	gmp_plugin_lock(dev->plugin);
+	error = dev->plugin->descr->dev_handle_events(dev, pfds,
+	    pfds_count);
+	gmp_plugin_unlock(dev->plugin);
+
+	return (error);
+}
+
+
+static int
+gmp_dev_read_batch(gmp_dev_p dev, gmp_dev_snapshot_p snap) {
+	int error;
+
+	if (NULL != dev->plugin->descr->dev_read_all)
+		return (dev->plugin->descr->dev_read_all(dev,
+		    snap->lines_mask, snap->states));
+	/* Fallback to line by line read. */
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		if (0 == GMP_LINES_MASK_IS_SET(snap->lines_mask, i))
+			continue;
+		error = dev->plugin->descr->dev_line_read(dev,
+		    gmp_dev_line_get(dev, i), &snap->states[i]);
+		if (0 != error)
+			return (error);
+	}
+
+	return (0);
+}
+
+static int
+gmp_dev_write_batch(gmp_dev_p dev, gmp_dev_snapshot_p snap) {
+	int error;
 
-	memset(&state_muted, 0x00, sizeof(state_muted));
+	if (NULL != dev->plugin->descr->dev_write_batch)
+		return (dev->plugin->descr->dev_write_batch(dev,
+		    snap->lines_mask, snap->states));
+	/* Fallback to line by line write. */
 	for (size_t i = 0; i < dev->lines_count; i ++) {
-		dev_line = &dev->lines[i];
-		if (0 == force && 0 == dev_line->read_required)
+		if (0 == GMP_LINES_MASK_IS_SET(snap->lines_mask, i))
 			continue;
-		/* Prepare to read. */
-		memset(&state, 0x00, sizeof(state));
-		state.is_enabled = dev_line->state.is_enabled;
-		/* Read. */
-		error = dev->plugin->descr->dev_line_read(dev, dev_line,
-		    &state);
-		/* Handle errors. */
+		error = dev->plugin->descr->dev_line_write(dev,
+		    gmp_dev_line_get(dev, i), &snap->states[i]);
 		if (0 != error)
 			return (error);
-		gmp_dev_line_state_vol_normalize(&state, dev_line->chan_map);
-		dev_line->read_required = 0;
+	}
+
+	return (0);
+}
+
+gmp_dev_snapshot_p
+gmp_dev_snapshot_alloc(gmp_dev_p dev) {
+	size_t mask_count;
+	gmp_dev_snapshot_p snap;
+
+	if (NULL == dev)
+		return (NULL);
+
+	/* Single allocation: header, write_gens, mask, states. */
+	mask_count = (GMP_LINES_MASK_COUNT(dev->lines_count) + 1);
+	snap = calloc(1, (sizeof(gmp_dev_snapshot_t) +
+	    ((dev->lines_count + 1) * sizeof(uint64_t)) +
+	    (mask_count * sizeof(size_t)) +
+	    ((dev->lines_count + 1) * sizeof(gmp_dev_line_state_t))));
+	if (NULL == snap)
+		return (NULL);
+	snap->lines_count = dev->lines_count;
+	snap->write_gens = (uint64_t*)(void*)(snap + 1);
+	snap->lines_mask = (size_t*)(void*)
+	    &snap->write_gens[(dev->lines_count + 1)];
+	snap->states = (gmp_dev_line_state_p)(void*)
+	    &snap->lines_mask[mask_count];
+
+	return (snap);
+}
+
+int
+gmp_dev_snapshot_read(gmp_dev_p dev, gmp_dev_snapshot_p snap,
+    int force, size_t *lines_read) {
+	int error = 0;
+	size_t lines_count = 0, mask_count;
+
+	if (NULL != lines_read) {
+		(*lines_read) = 0;
+	}
+	if (NULL == dev || NULL == snap || NULL == dev->read_mask ||
+	    snap->lines_count != dev->lines_count)
+		return (EINVAL);
+
+	gmp_plugin_lock(dev->plugin);
+	/* Backend know that nothing changed: read only requested lines. */
+	if (0 != force &&
+	    NULL != dev->plugin->descr->dev_is_changed &&
+	    0 == dev->plugin->descr->dev_is_changed(dev)) {
+		force = 0;
+	}
+
+	/* Prepare to read. */
+	mask_count = GMP_LINES_MASK_COUNT(dev->lines_count);
+	if (0 != force) {
+		memset(snap->lines_mask, 0x00, (mask_count * sizeof(size_t)));
+		for (size_t i = 0; i < dev->lines_count; i ++) {
+			GMP_LINES_MASK_SET(snap->lines_mask, i);
+		}
+	} else {
+		memcpy(snap->lines_mask, dev->read_mask,
+		    (mask_count * sizeof(size_t)));
+	}
+	for (size_t i = gmp_lines_mask_next(snap->lines_mask,
+	    dev->lines_count, 0);
+	    i < dev->lines_count;
+	    i = gmp_lines_mask_next(snap->lines_mask, dev->lines_count,
+	    (i + 1))) {
+		memset(&snap->states[i], 0x00, sizeof(gmp_dev_line_state_t));
+		lines_count ++;
+	}
+	if (0 == lines_count)
+		goto out;
+	/* Read. */
+	error = gmp_dev_read_batch(dev, snap);
+	if (0 != error)
+		goto out;
+	for (size_t i = 0; i < mask_count; i ++) {
+		dev->read_mask[i] &= ~snap->lines_mask[i];
+	}
+	if (NULL != lines_read) {
+		(*lines_read) = lines_count;
+	}
+out:
+	gmp_plugin_unlock(dev->plugin);
+
+	return (error);
+}
+
+size_t
+gmp_dev_snapshot_read_apply(gmp_dev_p dev, gmp_dev_snapshot_p snap) {
+	size_t ret = 0;
+	gmp_dev_line_p dev_line;
+	gmp_dev_line_state_p state;
+
+	if (NULL == dev || NULL == snap || NULL == dev->write_mask ||
+	    snap->lines_count != dev->lines_count)
+		return (0);
+
+	for (size_t i = gmp_lines_mask_next(snap->lines_mask,
+	    dev->lines_count, 0);
+	    i < dev->lines_count;
+	    i = gmp_lines_mask_next(snap->lines_mask, dev->lines_count,
+	    (i + 1))) {
+		if (GMP_LINES_MASK_IS_SET(dev->write_mask, i))
+			continue; /* Pending write from app wins. */
+		dev_line = gmp_dev_line_get(dev, i);
+		state = &snap->states[i];
+		gmp_vol_clamp(state->chan_vol, dev_line->chan_vol_count);
 		/* Detect changes. */
 		if (0 != dev_line->has_enable) {
 			/* Backend support mute, compare whole state. */
-			if (0 == memcmp(&state, &dev_line->state,
-			    sizeof(state)))
+			if (state->is_enabled == dev_line->state.is_enabled &&
+			    gmp_vol_is_equal(state->chan_vol,
+			    dev_line->state.chan_vol, dev_line->chan_vol_count))
 				continue; /* No changes. */
 		} else if (dev_line->state.is_enabled) {
 			/* Umuted, detect vol changes. */
-			if (0 == memcmp(state.chan_vol,
-			    dev_line->state.chan_vol,
-			    sizeof(state.chan_vol)))
+			state->is_enabled = 1;
+			if (gmp_vol_is_equal(state->chan_vol,
+			    dev_line->state.chan_vol, dev_line->chan_vol_count))
 				continue; /* No changes. */
 		} else { /* Muted, is unmuted? */
 			/* On mute all channels volumes must be 0. */
-			if (0 == memcmp(state_muted.chan_vol,
-			    state.chan_vol,
-			    sizeof((state.chan_vol))))
+			if (gmp_vol_is_zero(state->chan_vol,
+			    dev_line->chan_vol_count))
 				continue; /* No changes. */
 			/* Mark as unmuted + updated. */
-			state.is_enabled = 1;
+			state->is_enabled = 1;
 		}
 		/* Update device line state. */
-		dev_line->is_updated = 1; /* Mark as updated. */
-		memcpy(&dev_line->state, &state, sizeof(state));
+		memcpy(&dev_line->state, state, sizeof(gmp_dev_line_state_t));
+		gmp_dev_line_changed(dev_line, 0);
+		ret ++;
 	}
 
-	return (0);
+	return (ret);
 }
 
-int
-gmp_dev_write(gmp_dev_p dev, int force) {
-	int error;
+size_t
+gmp_dev_snapshot_write_prepare(gmp_dev_p dev, gmp_dev_snapshot_p snap,
+    int force) {
+	size_t lines_count = 0;
 	gmp_dev_line_p dev_line;
-	gmp_dev_line_state_t state_muted;
+	gmp_dev_line_state_p state;
 
-	if (NULL == dev)
-		return (EINVAL);
+	if (NULL == dev || NULL == snap || NULL == dev->write_mask ||
+	    snap->lines_count != dev->lines_count)
+		return (0);
 
-	memset(&state_muted, 0x00, sizeof(state_muted));
-	for (size_t i = 0; i < dev->lines_count; i ++) {
-		dev_line = &dev->lines[i];
-		if (0 == force && 0 == dev_line->write_required)
-			continue;
+	memset(snap->lines_mask, 0x00,
+	    (GMP_LINES_MASK_COUNT(dev->lines_count) * sizeof(size_t)));
+	for (size_t i = ((0 != force) ? 0 :
+	    gmp_lines_mask_next(dev->write_mask, dev->lines_count, 0));
+	    i < dev->lines_count;
+	    i = ((0 != force) ? (i + 1) :
+	    gmp_lines_mask_next(dev->write_mask, dev->lines_count, (i + 1)))) {
+		dev_line = gmp_dev_line_get(dev, i);
 		if (0 != dev_line->is_read_only)
 			continue;
-		/* Write. */
+		GMP_LINES_MASK_SET(snap->lines_mask, i);
+		snap->write_gens[i] = dev_line->gen;
+		state = &snap->states[i];
 		if (0 == dev_line->state.is_enabled &&
 		    0 == dev_line->has_enable) {
 			/* Set volumes to zero to simulate line disable. */
-			error = dev->plugin->descr->dev_line_write(dev,
-			    dev_line, &state_muted);
+			memset(state, 0x00, sizeof(gmp_dev_line_state_t));
 		} else { /* Set actual levels. */
-			gmp_dev_line_state_vol_normalize(&dev_line->state,
-			    dev_line->chan_map);
-			error = dev->plugin->descr->dev_line_write(dev,
-			    dev_line, &dev_line->state);
+			gmp_vol_clamp(dev_line->state.chan_vol,
+			    dev_line->chan_vol_count);
+			memcpy(state, &dev_line->state,
+			    sizeof(gmp_dev_line_state_t));
 		}
-		/* Handle errors. */
-		if (0 != error)
-			return (error);
-		dev_line->write_required = 0;
+		lines_count ++;
 	}
 
-	return (0);
+	return (lines_count);
 }
 
-
 int
-gmp_dev_is_updated(gmp_dev_p dev) {
+gmp_dev_snapshot_write(gmp_dev_p dev, gmp_dev_snapshot_p snap) {
+	int error;
 
-	if (NULL == dev || NULL == dev->lines)
-		return (0);
+	if (NULL == dev || NULL == snap ||
+	    snap->lines_count != dev->lines_count)
+		return (EINVAL);
 
-	for (size_t i = 0; i < dev->lines_count; i ++) {
-		if (0 != dev->lines[i].is_updated)
-			return (1);
+	gmp_plugin_lock(dev->plugin);
+	error = gmp_dev_write_batch(dev, snap);
+	gmp_plugin_unlock(dev->plugin);
+
+	return (error);
+}
+
+void
+gmp_dev_snapshot_write_apply(gmp_dev_p dev, gmp_dev_snapshot_p snap) {
+	gmp_dev_line_p dev_line;
+
+	if (NULL == dev || NULL == snap || NULL == dev->write_mask ||
+	    snap->lines_count != dev->lines_count)
+		return;
+
+	for (size_t i = gmp_lines_mask_next(snap->lines_mask,
+	    dev->lines_count, 0);
+	    i < dev->lines_count;
+	    i = gmp_lines_mask_next(snap->lines_mask, dev->lines_count,
+	    (i + 1))) {
+		dev_line = gmp_dev_line_get(dev, i);
+		/* Changes made after prepare still must be written. */
+		if (dev_line->gen != snap->write_gens[i])
+			continue;
+		GMP_LINES_MASK_CLR(dev->write_mask, i);
+		/* Backend may report actual enabled state. */
+		if (0 != dev_line->has_enable &&
+		    dev_line->state.is_enabled != snap->states[i].is_enabled) {
+			dev_line->state.is_enabled =
+			    snap->states[i].is_enabled;
+			gmp_dev_line_changed(dev_line, 0);
+		}
 	}
+}
+
+int
+gmp_dev_read(gmp_dev_p dev, int force) {
+	int error;
+	size_t lines_read;
+
+	if (NULL == dev || NULL == dev->snapshot)
+		return (EINVAL);
+
+	error = gmp_dev_snapshot_read(dev, dev->snapshot, force,
+	    &lines_read);
+	if (0 != error || 0 == lines_read)
+		return (error);
+	gmp_dev_snapshot_read_apply(dev, dev->snapshot);
 
 	return (0);
 }
 
-size_t
-gmp_dev_is_updated_clear(gmp_dev_p dev) {
-	size_t ret = 0;
+int
+gmp_dev_write(gmp_dev_p dev, int force) {
+	int error;
+
+	if (NULL == dev || NULL == dev->snapshot)
+		return (EINVAL);
 
-	if (NULL == dev || NULL == dev->lines)
+	if (0 == gmp_dev_snapshot_write_prepare(dev, dev->snapshot, force))
 		return (0);
+	error = gmp_dev_snapshot_write(dev, dev->snapshot);
+	if (0 != error)
+		return (error);
+	gmp_dev_snapshot_write_apply(dev, dev->snapshot);
 
-	for (size_t i = 0; i < dev->lines_count; i ++) {
-		ret += (0 != dev->lines[i].is_updated);
-		dev->lines[i].is_updated = 0;
-	}
+	return (0);
+}
 
-	return (ret);
+gmp_dev_line_p
+gmp_dev_changes_first(gmp_dev_p dev, const uint64_t gen) {
+
+	if (NULL == dev || NULL == dev->chg_head ||
+	    gen >= dev->chg_head->gen)
+		return (NULL);
+
+	return (dev->chg_head);
+}
+
+gmp_dev_line_p
+gmp_dev_changes_next(gmp_dev_line_p dev_line, const uint64_t gen) {
+
+	if (NULL == dev_line || NULL == dev_line->chg_next ||
+	    gen >= dev_line->chg_next->gen)
+		return (NULL);
+
+	return (dev_line->chg_next);
 }
 
 
@@ -481,22 +1537,31 @@ int
 gmp_dev_line_add(gmp_dev_p dev, const char *display_name,
     gmp_dev_line_p *dev_line_ret) {
 	char *dn;
-	gmp_dev_line_p dev_line, dev_line_new;
+	size_t chunk;
+	gmp_dev_line_p dev_line;
 
 	if (NULL == dev || NULL == display_name)
 		return (EINVAL);
 
-	dev_line_new = reallocarray(dev->lines, (dev->lines_count + 2),
-	    sizeof(gmp_dev_line_t));
-	if (NULL == dev_line_new)
+	/* Lines never moved: already returned pointers stay valid. */
+	chunk = gmp_dev_lines_chunk(dev->lines_count);
+	if (GMP_DEV_LINES_CHUNKS_MAX <= chunk)
+		return (ENOSPC);
+	if (NULL == dev->lines[chunk]) {
+		dev->lines[chunk] = calloc(GMP_DEV_LINES_CHUNK_SIZE(chunk),
+		    sizeof(gmp_dev_line_t));
+		if (NULL == dev->lines[chunk])
+			return (ENOMEM);
+	}
+	dn = strdup(display_name);
+	if (NULL == dn)
 		return (ENOMEM);
-	dev->lines = dev_line_new;
-	dev_line = &dev->lines[dev->lines_count];
-	dev->lines_count ++;
-
+	dev_line = gmp_dev_line_get(dev, dev->lines_count);
 	memset(dev_line, 0x00, sizeof(gmp_dev_line_t));
+	dev_line->dev = dev;
+	dev_line->idx = dev->lines_count;
+	dev->lines_count ++;
 	/* Remove spaces from end. */
-	dn = strdup(display_name);
 	for (size_t i = strlen(dn); 0 < i; i --) {
 		if (' ' != dn[(i - 1)])
 			break;
@@ -511,21 +1576,53 @@ gmp_dev_line_add(gmp_dev_p dev, const char *display_name,
 	return (0);
 }
 
+void
+gmp_dev_line_read_required(gmp_dev_line_p dev_line) {
+
+	if (NULL == dev_line || NULL == dev_line->dev->read_mask)
+		return; /* Device init: all lines will be read. */
+	GMP_LINES_MASK_SET(dev_line->dev->read_mask,
+	    gmp_dev_line_idx(dev_line));
+}
+
+void
+gmp_dev_line_changed(gmp_dev_line_p dev_line, const int is_app) {
+	gmp_dev_p dev;
+
+	if (NULL == dev_line)
+		return;
+	dev = dev_line->dev;
+	dev->gen ++;
+	dev_line->gen = dev->gen;
+	if (0 != is_app && NULL != dev->write_mask) {
+		GMP_LINES_MASK_SET(dev->write_mask,
+		    gmp_dev_line_idx(dev_line));
+	}
+	/* Move line to changes list head. */
+	if (dev->chg_head == dev_line)
+		return;
+	if (NULL != dev_line->chg_prev) { /* Unlink. */
+		dev_line->chg_prev->chg_next = dev_line->chg_next;
+		if (NULL != dev_line->chg_next) {
+			dev_line->chg_next->chg_prev = dev_line->chg_prev;
+		}
+	}
+	dev_line->chg_prev = NULL;
+	dev_line->chg_next = dev->chg_head;
+	if (NULL != dev->chg_head) {
+		dev->chg_head->chg_prev = dev_line;
+	}
+	dev->chg_head = dev_line;
+}
+
 int
 gmp_dev_line_vol_max_get(gmp_dev_line_p dev_line) {
-	int ret = 0;
 
 	if (NULL == dev_line)
 		return (0);
-	for (size_t i = 0; i < MIXER_CHANNELS_COUNT; i ++) {
-		if (0 == (((((uint32_t)1) << i) & dev_line->chan_map)))
-			continue;
-		if (ret < dev_line->state.chan_vol[i]) {
-			ret = dev_line->state.chan_vol[i];
-		}
-	}
 
-	return (ret);
+	return (gmp_vol_max(dev_line->state.chan_vol,
+	    dev_line->chan_vol_count));
 }
 
 void
@@ -533,12 +1630,8 @@ gmp_dev_line_vol_glob_set(gmp_dev_line_p dev_line, int vol_new) {
 
 	if (NULL == dev_line)
 		return;
-	vol_new = volume_apply_limits(vol_new);
-	for (size_t i = 0; i < MIXER_CHANNELS_COUNT; i ++) {
-		if (0 == (((((uint32_t)1) << i) & dev_line->chan_map)))
-			continue;
-		dev_line->state.chan_vol[i] = vol_new;
-	}
+	gmp_vol_fill(dev_line->state.chan_vol, dev_line->chan_vol_count,
+	    volume_apply_limits(vol_new));
 }
 
 void
@@ -546,37 +1639,27 @@ gmp_dev_line_vol_glob_add(gmp_dev_line_p dev_line, int vol) {
 
 	if (NULL == dev_line)
 		return;
-	for (size_t i = 0; i < MIXER_CHANNELS_COUNT; i ++) {
-		if (0 == (((((uint32_t)1) << i) & dev_line->chan_map)))
-			continue;
-		dev_line->state.chan_vol[i] = volume_apply_limits(
-		    (vol + dev_line->state.chan_vol[i]));
-	}
+	gmp_vol_add(dev_line->state.chan_vol, dev_line->chan_vol_count, vol);
 }
 
 size_t
 gmp_dev_line_chan_first(gmp_dev_line_p dev_line) {
 
-	if (NULL == dev_line)
+	if (NULL == dev_line || 0 == dev_line->chan_map)
 		return (MIXER_CHANNELS_COUNT);
-	for (size_t i = 0; i < MIXER_CHANNELS_COUNT; i ++) {
-		if (0 == (((((uint32_t)1) << i) & dev_line->chan_map)))
-			continue;
-		return (i);
-	}
 
-	return (MIXER_CHANNELS_COUNT);
+	return ((size_t)__builtin_ctzll(dev_line->chan_map));
 }
 size_t
 gmp_dev_line_chan_next(gmp_dev_line_p dev_line, size_t cur) {
+	uint64_t chan_map;
 
-	if (NULL == dev_line)
+	if (NULL == dev_line || (MIXER_CHANNELS_COUNT - 1) <= cur)
+		return (MIXER_CHANNELS_COUNT);
+	/* Drop cur and lower channels. */
+	chan_map = (dev_line->chan_map & ~((((uint64_t)2) << cur) - 1));
+	if (0 == chan_map)
 		return (MIXER_CHANNELS_COUNT);
-	for (size_t i = (cur + 1); i < MIXER_CHANNELS_COUNT; i ++) {
-		if (0 == (((((uint32_t)1) << i) & dev_line->chan_map)))
-			continue;
-		return (i);
-	}
 
-	return (MIXER_CHANNELS_COUNT);
+	return ((size_t)__builtin_ctzll(chan_map));
 }
@@ -34,6 +34,8 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <inttypes.h>
+#include <poll.h>
+#include <stdatomic.h>
 
 #ifndef __unused
 #	define __unused		__attribute__((__unused__))
@@ -71,8 +73,19 @@ typedef struct gtk_mixer_plugin_device_list_s *gmp_dev_list_p;
 typedef struct gtk_mixer_plugin_device_s *gmp_dev_p;
 typedef struct gtk_mixer_plugin_device_line_s *gmp_dev_line_p;
 typedef struct gtk_mixer_plugin_device_line_state_s *gmp_dev_line_state_p;
+typedef struct gtk_mixer_plugin_device_snapshot_s *gmp_dev_snapshot_p;
+typedef struct gtk_mixer_plugin_worker_s *gmp_worker_p;
+typedef struct gtk_mixer_plugin_worker_trash_s *gmp_worker_trash_p;
+typedef struct gtk_mixer_plugin_str_pool_s *gmp_str_pool_p;
 
 
+/* Device nodes to watch for hotplug: files with name prefix in dir. */
+#define GMP_HOTPLUG_NODES_MAX	4
+typedef struct gtk_mixer_plugin_hotplug_node_s {
+	const char *dir;
+	const char *prefix;
+} gmp_hotplug_node_t;
+
 /* Discribe plugin API. */
 typedef struct gtk_mixer_plugin_description_s {
 	const char *name;
@@ -99,6 +112,24 @@ typedef struct gtk_mixer_plugin_description_s {
 	/* 0 - no change. If not defined - list_devs() will be called. */
 	int (*is_list_devs_changed)(gm_plugin_p plugin);
 
+	/* Optional. Device nodes, that appear/disappear with devices.
+	 * Up to GMP_HOTPLUG_NODES_MAX, last item must have dir = NULL.
+	 * If all dirs watched by gmp_hotplug_open() then
+	 * is_list_devs_changed() is not called. */
+	const gmp_hotplug_node_t *hotplug_nodes;
+
+	/* Update scheduler hints. */
+	/* Changes that plugin can report without polling. */
+	#define GMP_NOTIFY_LINES	0x01 /* Lines via dev_poll_descriptors(). */
+	#define GMP_NOTIFY_DEVS		0x02 /* Devices add/remove via hotplug_nodes. */
+	#define GMP_NOTIFY_DEF_DEV	0x04 /* No default device or it is not polled. */
+	uint32_t notify;
+	/* Poll cost: poll interval multiplier. 0 = GMP_POLL_COST_LOW. */
+	#define GMP_POLL_COST_LOW	1 /* Few syscalls. */
+	#define GMP_POLL_COST_MEDIUM	2
+	#define GMP_POLL_COST_HIGH	4 /* Open/read/parse files, IPC. */
+	uint32_t poll_cost;
+
 
 	/* Plugin device level functions. */
 
@@ -124,24 +155,73 @@ typedef struct gtk_mixer_plugin_description_s {
 	/* Optional. Can be used to free device line priv data that was set inside dev_init(). */
 	void (*dev_line_destroy)(gmp_dev_p dev, gmp_dev_line_p dev_line);
 
+	/* Optional. 0 - device lines state not changed since last call,
+	 * forced gmp_dev_read() will skip lines read. */
+	int (*dev_is_changed)(gmp_dev_p dev);
+
 	/* Read from mixer dev line to app. 0 - no error. */
 	int (*dev_line_read)(gmp_dev_p dev, gmp_dev_line_p dev_line,
 	    gmp_dev_line_state_p line_state);
 	/* Write from app to mixer dev line. 0 - no error. */
 	int (*dev_line_write)(gmp_dev_p dev, gmp_dev_line_p dev_line,
 	    gmp_dev_line_state_p line_state);
+
+	/* Optional. Batch versions of dev_line_read()/dev_line_write().
+	 * Process only lines with bit set in lines_mask, line_states[]
+	 * is indexed by line index: gmp_dev_line_get().
+	 * If not defined - dev_line_read()/dev_line_write() will be
+	 * called for each line. 0 - no error.
+	 * Note: all plugin device I/O functions may be called from plugin
+	 * worker thread, calls are serialized per plugin. */
+	int (*dev_read_all)(gmp_dev_p dev, const size_t *lines_mask,
+	    gmp_dev_line_state_p line_states);
+	int (*dev_write_batch)(gmp_dev_p dev, const size_t *lines_mask,
+	    gmp_dev_line_state_p line_states);
+
+	/* Optional. Get descriptors to poll for device change events.
+	 * Return descriptors count stored to pfds. If pfds is NULL or
+	 * pfds_count is too small - return required pfds_count. */
+	int (*dev_poll_descriptors)(gmp_dev_p dev, struct pollfd *pfds,
+	    size_t pfds_count);
+	/* Optional. Process events after poll() on descriptors returned
+	 * by dev_poll_descriptors(). Changed lines must be marked by
+	 * gmp_dev_line_read_required(). 0 - no error. */
+	int (*dev_handle_events)(gmp_dev_p dev, struct pollfd *pfds,
+	    size_t pfds_count);
 } gmp_descr_t, *gmp_descr_p;
 
 
 typedef struct gtk_mixer_plugin_s {
 	const gmp_descr_t *descr;
 	void 		*priv; /* Plugin internal. */
+	/* Used by hotplug watcher. */
+	int		hotplug_wd[GMP_HOTPLUG_NODES_MAX]; /* Watch descriptors. */
+	int		hotplug_watched; /* All hotplug_nodes dirs watched. */
+	int		hotplug_changed; /* Nodes changed since last check. */
+	/* list_devs() output fingerprints: used if plugin does not
+	 * have is_list_devs_changed() / is_def_dev_changed(). */
+	uint64_t	fp_list; /* Devices names and descriptions. */
+	uint64_t	fp_def; /* Default devices flags. */
+	int		fp_def_changed; /* fp_def changed, not reported yet. */
+	int		fp_updated; /* fp_* updated since last def check. */
+	/* Backend I/O worker thread, NULL - plugin called from GUI thread. */
+	gmp_worker_p	worker;
+	int		worker_list_changed; /* Reported by worker, not consumed. */
+	int		worker_def_changed;
+	int		is_stalled; /* Worker call exceed deadline. */
+	int		def_dev_separate; /* is_def_dev_separate() on list. */
+	gmp_dev_list_p	dev_list; /* Scanned, not applied to devices set. */
+	/* Interned devices names and descriptions, freed on uninit. */
+	gmp_str_pool_p	str_pool;
 } gm_plugin_t, *gm_plugin_p;
 
 
 
-/* From: https://en.wikipedia.org/wiki/Surround_sound */
-#define MIXER_CHANNELS_COUNT	18
+/* From: https://en.wikipedia.org/wiki/Surround_sound
+ * Channel positions, bit index in chan_map. Channels without known
+ * position use MIXER_CHANNEL_AUX*. */
+#define MIXER_CHANNELS_AUX_COUNT	23
+#define MIXER_CHANNELS_COUNT	(MIXER_CHANNEL_AUX0 + MIXER_CHANNELS_AUX_COUNT)
 enum {
 	MIXER_CHANNEL_FL = 0,
 	MIXER_CHANNEL_FR,
@@ -160,7 +240,8 @@ enum {
 	MIXER_CHANNEL_TFR,
 	MIXER_CHANNEL_TBL,
 	MIXER_CHANNEL_TBC,
-	MIXER_CHANNEL_TBR
+	MIXER_CHANNEL_TBR,
+	MIXER_CHANNEL_AUX0
 };
 
 static const char *channel_name_long[MIXER_CHANNELS_COUNT] = {
@@ -182,6 +263,29 @@ static const char *channel_name_long[MIXER_CHANNELS_COUNT] = {
 	"Rear Left Height",
 	"Rear Center Height",
 	"Rear Right Height",
+	"Auxiliary 1",
+	"Auxiliary 2",
+	"Auxiliary 3",
+	"Auxiliary 4",
+	"Auxiliary 5",
+	"Auxiliary 6",
+	"Auxiliary 7",
+	"Auxiliary 8",
+	"Auxiliary 9",
+	"Auxiliary 10",
+	"Auxiliary 11",
+	"Auxiliary 12",
+	"Auxiliary 13",
+	"Auxiliary 14",
+	"Auxiliary 15",
+	"Auxiliary 16",
+	"Auxiliary 17",
+	"Auxiliary 18",
+	"Auxiliary 19",
+	"Auxiliary 20",
+	"Auxiliary 21",
+	"Auxiliary 22",
+	"Auxiliary 23",
 };
 
 static const char *channel_name_short[MIXER_CHANNELS_COUNT] = {
@@ -202,7 +306,30 @@ static const char *channel_name_short[MIXER_CHANNELS_COUNT] = {
 	"TFR",
 	"TBL",
 	"TBC",
-	"TBR"
+	"TBR",
+	"AUX1",
+	"AUX2",
+	"AUX3",
+	"AUX4",
+	"AUX5",
+	"AUX6",
+	"AUX7",
+	"AUX8",
+	"AUX9",
+	"AUX10",
+	"AUX11",
+	"AUX12",
+	"AUX13",
+	"AUX14",
+	"AUX15",
+	"AUX16",
+	"AUX17",
+	"AUX18",
+	"AUX19",
+	"AUX20",
+	"AUX21",
+	"AUX22",
+	"AUX23",
 };
 
 
@@ -210,32 +337,61 @@ static const char *channel_name_short[MIXER_CHANNELS_COUNT] = {
 
 /* This is for read/write. */
 #define GMPDL_CHAN_VOL_INVALID	0xffffff
+#define GMPDL_CHAN_VOL_MAX	32 /* Max channels per line. */
 typedef struct gtk_mixer_plugin_device_line_state_s {
-	int chan_vol[MIXER_CHANNELS_COUNT]; /* Volume level per channel: 0-100. */
+	/* Volume level per channel: 0-100. Packed: chan_vol[i] is i-th
+	 * channel from chan_map, only chan_vol_count items are used.
+	 * Use gmp_dev_line_chan_idx() to get index by position. */
+	int chan_vol[GMPDL_CHAN_VOL_MAX];
 	int is_enabled; /* 0 - is line muted / record disabled. */
 } gmp_dev_line_state_t;
 
+/* Lines bitmask: 1 bit per line index. */
+#define GMP_LINES_MASK_BITS		(sizeof(size_t) * 8)
+#define GMP_LINES_MASK_COUNT(__lines)					\
+	(((__lines) + GMP_LINES_MASK_BITS - 1) / GMP_LINES_MASK_BITS)
+#define GMP_LINES_MASK_SET(__mask, __idx)				\
+	(__mask)[((__idx) / GMP_LINES_MASK_BITS)] |=			\
+	    (((size_t)1) << ((__idx) % GMP_LINES_MASK_BITS))
+#define GMP_LINES_MASK_CLR(__mask, __idx)				\
+	(__mask)[((__idx) / GMP_LINES_MASK_BITS)] &=			\
+	    ~(((size_t)1) << ((__idx) % GMP_LINES_MASK_BITS))
+#define GMP_LINES_MASK_IS_SET(__mask, __idx)				\
+	(0 != ((__mask)[((__idx) / GMP_LINES_MASK_BITS)] &		\
+	    (((size_t)1) << ((__idx) % GMP_LINES_MASK_BITS))))
+
 /* Keep all soundcard line data. */
 typedef struct gtk_mixer_plugin_device_line_s {
 	/* Set by plugin. */
 	const char *display_name; /* Line name to display: main, pcm, mic... */
 	void *priv; /* Plugin internal per device line. */
-	uint32_t chan_map; /* Bitmask for avail channels. */
+	uint64_t chan_map; /* Bitmask for avail channels: MIXER_CHANNEL_*. */
 	size_t chan_vol_count; /* Actual channels count. popcnt(chan_map) */
 	int is_capture; /* Device is capture else playback. */
 	int is_read_only; /* Only display values, no set. */
 	int has_enable; /* Line can be enabled/disabled. (muted) */
 
 	/* Used by app. */
+	gmp_dev_p dev; /* Owner, set by gmp_dev_line_add(). */
+	size_t idx; /* Index in device lines. */
 	gmp_dev_line_state_t state;
-	ssize_t is_updated; /* State changed, need GUI update. -1 = set from gui, 1 = set from backend. */
-	size_t read_required; /* Plugin must read state from mixer. */
-	size_t write_required; /* Plugin must write state to mixer. */
+	uint64_t gen; /* Device gen of last state change. */
+	gmp_dev_line_p chg_prev; /* Device changes list, newest first. */
+	gmp_dev_line_p chg_next;
 } gmp_dev_line_t, *gmp_dev_line_p;
 
 
 /* Soundcard. */
 
+/* Lines storage: chunks, each next 2x bigger, lines never moved, so
+ * gmp_dev_line_p valid until dev_uninit. Use gmp_dev_line_get(). */
+#define GMP_DEV_LINES_CHUNK_SHIFT	4 /* First chunk: 16 lines. */
+#define GMP_DEV_LINES_CHUNKS_MAX	24
+#define GMP_DEV_LINES_CHUNK_START(__chunk)				\
+	(((((size_t)1) << (__chunk)) - 1) << GMP_DEV_LINES_CHUNK_SHIFT)
+#define GMP_DEV_LINES_CHUNK_SIZE(__chunk)				\
+	(((size_t)1) << ((__chunk) + GMP_DEV_LINES_CHUNK_SHIFT))
+
 /* Keep all soundcard device data. */
 typedef struct gtk_mixer_plugin_device_s {
 	/* Set by plugin. */
@@ -245,15 +401,64 @@ typedef struct gtk_mixer_plugin_device_s {
 	void *priv; /* Plugin internal per device. Handle it on dev_init()/dev_uninit() or list_devs()/dev_destroy(). */
 
 	/* Used by app. */
-	gmp_dev_line_p lines; /* Auto destroy on dev_uninit. */
+	/* Lines chunks. Auto destroy on dev_uninit. */
+	gmp_dev_line_p lines[GMP_DEV_LINES_CHUNKS_MAX];
 	size_t lines_count;
+	gmp_dev_snapshot_p snapshot; /* gmp_dev_read()/gmp_dev_write() buffer. */
+	/* Worker requests buffers: one request of each kind in flight. */
+	gmp_dev_snapshot_p snap_read;
+	gmp_dev_snapshot_p snap_write;
+	gmp_dev_snapshot_p snap_events;
+	/* Lines changes tracking: each state change increment gen and
+	 * move line to chg_head, so consumers that remember last seen
+	 * gen can walk only lines changed since. */
+	uint64_t gen; /* Monotonic, not reset on uninit. */
+	gmp_dev_line_p chg_head; /* Last changed line. */
+	size_t *read_mask; /* Lines that plugin must read from mixer. */
+	size_t *write_mask; /* Lines changed by app, not written yet. */
+	int def_flags; /* DEV_IS_*, dev_is_default() on list. */
+	/* Changed with plugin lock held, read by GUI without lock. */
+#define GMP_DEV_INIT_NONE	0
+#define GMP_DEV_INIT_DONE	1
+#define GMP_DEV_INIT_ERROR	2 /* Init by worker failed: init_error. */
+	_Atomic int init_state;
+	int init_error; /* gmp_dev_init_async() result, reported once. */
 } gmp_dev_t, *gmp_dev_p;
 
+/* Lines state snapshot: batch read/write buffer.
+ * Filled by one thread and then passed to other as is.
+ * Allocated by gmp_dev_snapshot_alloc(), free with free().
+ * Device snapshots are allocated on init and reused. */
+typedef struct gtk_mixer_plugin_device_snapshot_s {
+	size_t lines_count; /* Must match device lines_count. */
+	size_t *lines_mask; /* Lines to read/write. */
+	uint64_t *write_gens; /* Lines gen on write prepare. */
+	gmp_dev_line_state_p states; /* lines_count items. */
+} gmp_dev_snapshot_t;
+
 typedef struct gtk_mixer_plugin_device_list_s {
 	gmp_dev_p devs;
 	size_t count;
+	size_t allocated; /* devs array size, grow x2. */
+	int def_dev_separate; /* is_def_dev_separate() on list. */
 } gmp_dev_list_t, *gmp_dev_list_p;
 
+/* Persistent devices set: keep devices objects between lists scans.
+ * Devices objects pointers are stable while device present. */
+typedef struct gtk_mixer_plugin_device_set_s {
+	gmp_dev_p *devs; /* Last scan order. */
+	size_t count;
+	size_t *index; /* Hash (plugin, name) -> devs idx + 1. */
+	size_t index_size; /* Power of 2. */
+} gmp_dev_set_t, *gmp_dev_set_p;
+
+/* gmp_dev_set_apply() events. */
+#define GMP_DEV_SET_ADDED	1 /* idx - position in set. */
+#define GMP_DEV_SET_REMOVED	2 /* Called before device destroy. */
+#define GMP_DEV_SET_CHANGED	3 /* Description or default flags changed. */
+typedef void (*gmp_dev_set_cb)(gmp_dev_p dev, const int event,
+    const size_t idx, void *udata);
+
 
 
 int gmp_init(gm_plugin_p *plugins, size_t *plugins_count);
@@ -261,41 +466,216 @@ void gmp_uninit(gm_plugin_p plugins, const size_t plugins_count);
 
 int gmp_is_def_dev_changed(gm_plugin_p plugins, const size_t plugins_count);
 
+/* Cached by gmp_list_devs(). */
 int gmp_is_def_dev_separate(gm_plugin_p plugin);
 
+/* Update scheduler. */
+/* Return non zero if devices list or default device must be polled. */
+int gmp_is_poll_required(gm_plugin_p plugins, const size_t plugins_count);
+int gmp_plugin_is_poll_required(gm_plugin_p plugin);
+/* Return non zero if lines must be polled.
+ * is_events_attached - dev_poll_descriptors() are watched. */
+int gmp_dev_is_poll_required(gmp_dev_p dev, const int is_events_attached);
+/* Return max GMP_POLL_COST_* of plugins. */
+uint32_t gmp_poll_cost(gm_plugin_p plugins, const size_t plugins_count);
+
+/* Device nodes hotplug watcher.
+ * Return descriptor to poll for read or -1 if not supported. */
+int gmp_hotplug_open(gm_plugin_p plugins, const size_t plugins_count);
+void gmp_hotplug_close(gm_plugin_p plugins, const size_t plugins_count,
+    int fd);
+/* Read events, mark plugins with changed nodes.
+ * Return changed plugins count. */
+size_t gmp_hotplug_handle_events(gm_plugin_p plugins,
+    const size_t plugins_count, int fd);
+
+/* Also cache devices default flags: GUI does not call plugin for it. */
 int gmp_list_devs(gm_plugin_p plugins, const size_t plugins_count,
     gmp_dev_list_p dev_list);
 /* Does not free dev_list, work only with stored data. */
 void gmp_dev_list_clear(gmp_dev_list_p dev_list);
-gmp_dev_p gmp_dev_find_same(gmp_dev_list_p dev_list, gmp_dev_p dev);
+/* Devices name and description are interned by plugin: strings are
+ * shared by all lists and valid until gmp_uninit(). */
 int gmp_dev_list_add(gm_plugin_p plugin, gmp_dev_list_p dev_list,
     gmp_dev_p dev);
-gmp_dev_p gmp_dev_list_get_playback_default(gmp_dev_list_p dev_list);
+
+/* Merge plugins lists scanned by gmp_list_devs_async() into dev_set:
+ * devices that still present keep their objects (and initialized
+ * lines), only added/removed/changed devices reported to cb.
+ * Removed devices are destroyed by worker.
+ * Return number of merged lists. */
+size_t gmp_dev_set_apply(gmp_dev_set_p dev_set, gm_plugin_p plugins,
+    const size_t plugins_count, gmp_dev_set_cb cb, void *udata);
+/* name must be interned: taken from plugin device. */
+gmp_dev_p gmp_dev_set_find(gmp_dev_set_p dev_set, gm_plugin_p plugin,
+    const char *name);
+gmp_dev_p gmp_dev_set_get_playback_default(gmp_dev_set_p dev_set);
+void gmp_dev_set_clear(gmp_dev_set_p dev_set);
 
 int gmp_is_list_devs_changed(gm_plugin_p plugins, const size_t plugins_count);
 
+/* Single plugin checks, without hotplug watcher and worker results.
+ * Used by worker. */
+int gmp_plugin_is_list_devs_changed(gm_plugin_p plugin);
+int gmp_plugin_is_def_dev_changed(gm_plugin_p plugin);
+int gmp_plugin_list_devs(gm_plugin_p plugin, gmp_dev_list_p dev_list);
+/* Uninit and destroy plugin data, dev itself is not freed. */
+void gmp_dev_destroy(gmp_dev_p dev);
+
 int gmp_dev_init(gmp_dev_p dev);
 void gmp_dev_uninit(gmp_dev_p dev);
 
-/* Is mixer dev default?. Return flags DEV_IS_*. */
+/* Is mixer dev default?. Return flags DEV_IS_* on last list. */
 int gmp_dev_is_default(gmp_dev_p dev);
 /* Make mixer dev default. */
 int gmp_dev_set_default(gmp_dev_p dev, const uint32_t type);
 
+/* Get descriptors to poll for device events.
+ * Return descriptors count or required pfds_count if pfds is NULL.
+ * 0 - device does not support events. */
+size_t gmp_dev_poll_descriptors(gmp_dev_p dev, struct pollfd *pfds,
+    size_t pfds_count);
+/* Process device events, mark changed lines for read. */
+int gmp_dev_handle_events(gmp_dev_p dev, struct pollfd *pfds,
+    size_t pfds_count);
+
 /* Read from mixer dev. */
 int gmp_dev_read(gmp_dev_p dev, int force);
 /* Write to mixer dev new values. */
 int gmp_dev_write(gmp_dev_p dev, int force);
 
-/* Return 1 if at least 1 line gui update required. */
-int gmp_dev_is_updated(gmp_dev_p dev);
-/* Clear updated_clear, that was set by gmp_dev_read().
- * Return changes count. */
-size_t gmp_dev_is_updated_clear(gmp_dev_p dev);
+/* gmp_dev_read()/gmp_dev_write() split to steps, that can be done
+ * in different threads. */
+gmp_dev_snapshot_p gmp_dev_snapshot_alloc(gmp_dev_p dev);
+/* I/O: read lines from read_mask or all lines if force.
+ * Does not touch lines state. */
+int gmp_dev_snapshot_read(gmp_dev_p dev, gmp_dev_snapshot_p snap,
+    int force, size_t *lines_read);
+/* Update lines state from snap, changed lines gets new gen.
+ * Lines with pending writes are skipped. Return changed lines count. */
+size_t gmp_dev_snapshot_read_apply(gmp_dev_p dev, gmp_dev_snapshot_p snap);
+/* Copy lines from write_mask (all if force) to snap.
+ * Return lines count to write. */
+size_t gmp_dev_snapshot_write_prepare(gmp_dev_p dev,
+    gmp_dev_snapshot_p snap, int force);
+/* I/O: write lines from snap. */
+int gmp_dev_snapshot_write(gmp_dev_p dev, gmp_dev_snapshot_p snap);
+/* Clear write_mask for lines not changed since write prepare. */
+void gmp_dev_snapshot_write_apply(gmp_dev_p dev, gmp_dev_snapshot_p snap);
+
+/* Lines changed after gen, newest first. Walk time depend only
+ * on changed lines count. */
+gmp_dev_line_p gmp_dev_changes_first(gmp_dev_p dev, const uint64_t gen);
+gmp_dev_line_p gmp_dev_changes_next(gmp_dev_line_p dev_line,
+    const uint64_t gen);
+
+/* Backend I/O worker: plugin calls are done in own thread.
+ * Without worker all *_async() functions do I/O right now. */
+/* Start worker thread. Return descriptor to poll for read, results
+ * must be handled by gmp_worker_handle_results() or -1 on error. */
+int gmp_worker_start(gm_plugin_p plugin);
+/* Called by gmp_uninit(). Pending writes are done before stop.
+ * Return ETIMEDOUT if worker hung in plugin call: it is left
+ * running and plugin must not be used or freed. */
+int gmp_worker_stop(gm_plugin_p plugin);
+/* Serialize plugin calls with worker thread, recursive. */
+void gmp_plugin_lock(gm_plugin_p plugin);
+void gmp_plugin_unlock(gm_plugin_p plugin);
+/* Make worker watch device events and process device async I/O.
+ * Does not wait for busy worker: attach is done later by
+ * gmp_worker_handle_results() (GMP_WORKER_RES_EVENTS) or by next call.
+ * Return non zero if device events watched by worker. */
+int gmp_worker_dev_attach(gmp_dev_p dev);
+/* Also cancel queued init. */
+void gmp_worker_dev_detach(gmp_dev_p dev);
+/* Called by gmp_dev_uninit() with plugin lock held. */
+void gmp_worker_dev_release(gmp_dev_p dev);
+/* Called before devices set member destroy: device is detached,
+ * results of queued requests with device are ignored. */
+void gmp_worker_dev_destroy(gmp_dev_p dev);
+/* Devices to destroy: worker process them after all requests queued
+ * before, so device stay valid for them. */
+typedef struct gtk_mixer_plugin_worker_trash_s {
+	gmp_worker_trash_p next; /* Not sent yet, GUI thread only. */
+	gmp_dev_list_p	dev_list; /* Scan data: items destroyed. */
+	size_t		devs_count;
+	gmp_dev_p	devs[]; /* Destroyed and freed. */
+} gmp_worker_trash_t;
+gmp_worker_trash_p gmp_worker_trash_alloc(const size_t devs_count);
+/* Destroy and free trash by worker or right now if plugin without
+ * worker. dev_list must be allocated by malloc(), it is freed too. */
+void gmp_worker_trash_put(gm_plugin_p plugin, gmp_worker_trash_p trash);
+void gmp_worker_dev_list_destroy(gm_plugin_p plugin,
+    gmp_dev_list_p dev_list);
+int gmp_worker_dev_events_attached(gmp_dev_p dev);
+/* Queue device init, only last requested device per plugin is
+ * initialized: previous requests canceled.
+ * Return 0 if device ready, EINPROGRESS - wait for
+ * GMP_WORKER_RES_INIT and call again, or init error.
+ * Device must not be used while init in progress. */
+int gmp_dev_init_async(gmp_dev_p dev);
+/* Queue initialized device uninit, device must not be used after. */
+int gmp_dev_uninit_async(gmp_dev_p dev);
+/* Queue attached device read / lines from write_mask write of any
+ * initialized device.
+ * EBUSY - previous request in progress or attach is not done yet,
+ * request is sent automatically on completion. */
+int gmp_dev_read_async(gmp_dev_p dev, int force);
+int gmp_dev_write_async(gmp_dev_p dev);
+/* Queue make device default, done is reported by
+ * gmp_is_def_dev_changed(). */
+int gmp_dev_set_default_async(gmp_dev_p dev, const uint32_t type);
+/* Queue devices list and default device checks, result is reported
+ * by gmp_is_list_devs_changed() / gmp_is_def_dev_changed().
+ * Event driven plugins are skipped. */
+void gmp_check_async(gm_plugin_p plugins, const size_t plugins_count);
+/* Queue devices lists scan, lists are stored in plugin dev_list and
+ * merged by gmp_dev_set_apply() (GMP_WORKER_RES_LIST).
+ * Plugins without worker are listed right now: return its error. */
+int gmp_list_devs_async(gm_plugin_p plugins, const size_t plugins_count);
+/* Handle worker results. Return GMP_WORKER_RES_* flags. */
+#define GMP_WORKER_RES_LINES	0x01 /* Device lines updated. */
+#define GMP_WORKER_RES_CHECK	0x02 /* Devices list/default checked. */
+#define GMP_WORKER_RES_EVENTS	0x04 /* Device attached, events detached. */
+#define GMP_WORKER_RES_INIT	0x08 /* Device init done or canceled. */
+#define GMP_WORKER_RES_LIST	0x10 /* Devices list scanned. */
+uint32_t gmp_worker_handle_results(gm_plugin_p plugin);
+/* Mark plugins with calls longer than timeout (us) as stalled.
+ * Return stalled plugins count. */
+size_t gmp_worker_watchdog(gm_plugin_p plugins, const size_t plugins_count,
+    const uint64_t timeout);
+/* Return non zero if requests queued or plugin call in progress. */
+int gmp_worker_is_busy(gm_plugin_p plugins, const size_t plugins_count);
 
 /* Add line to device. */
 int gmp_dev_line_add(gmp_dev_p dev, const char *display_name,
     gmp_dev_line_p *dev_line_ret);
+/* Lines chunk index by line index. */
+static inline size_t
+gmp_dev_lines_chunk(const size_t idx) {
+
+	return ((size_t)(63 - __builtin_clzll((unsigned long long)
+	    ((idx >> GMP_DEV_LINES_CHUNK_SHIFT) + 1))));
+}
+/* Line by index, idx must be < lines_count. */
+static inline gmp_dev_line_p
+gmp_dev_line_get(gmp_dev_p dev, const size_t idx) {
+	const size_t chunk = gmp_dev_lines_chunk(idx);
+
+	return (&dev->lines[chunk][(idx - GMP_DEV_LINES_CHUNK_START(chunk))]);
+}
+/* Line index in device lines. */
+static inline size_t
+gmp_dev_line_idx(gmp_dev_line_p dev_line) {
+
+	return (dev_line->idx);
+}
+/* Mark line to read on next device read, used by plugins events
+ * handlers. */
+void gmp_dev_line_read_required(gmp_dev_line_p dev_line);
+/* Line state changed: set new gen. is_app - changed by app,
+ * line must be written to mixer. */
+void gmp_dev_line_changed(gmp_dev_line_p dev_line, const int is_app);
 
 /* Get max channel volume per line. */
 int gmp_dev_line_vol_max_get(gmp_dev_line_p dev_line);
@@ -303,9 +683,17 @@ int gmp_dev_line_vol_max_get(gmp_dev_line_p dev_line);
 void gmp_dev_line_vol_glob_set(gmp_dev_line_p dev_line, int vol_new);
 /* Increment/decrement volume. */
 void gmp_dev_line_vol_glob_add(gmp_dev_line_p dev_line, int vol);
-/* Get first/next channel index on line. */
+/* Get first/next channel position (MIXER_CHANNEL_*) on line.
+ * Return MIXER_CHANNELS_COUNT if no more channels. */
 size_t gmp_dev_line_chan_first(gmp_dev_line_p dev_line);
 size_t gmp_dev_line_chan_next(gmp_dev_line_p dev_line, size_t cur);
+/* Channel index in state chan_vol[] by channel position. */
+static inline size_t
+gmp_dev_line_chan_idx(gmp_dev_line_p dev_line, const size_t pos) {
+
+	return ((size_t)__builtin_popcountll(dev_line->chan_map &
+	    ((((uint64_t)1) << pos) - 1)));
+}
 
 
 #ifdef HAVE_OSS
@@ -65,6 +65,10 @@
 
 
 static const char *oss_line_labels[] = SOUND_DEVICE_LABELS;
+static const gmp_hotplug_node_t oss_hotplug_nodes[] = {
+	{ .dir = "/dev",	.prefix = "mixer" },
+	{ .dir = NULL,		.prefix = NULL }
+};
 
 enum {
 	MIXER_STATE_RECSRC = 0,
@@ -85,6 +89,10 @@ static const uint32_t mixer_state_id[] = {
 typedef struct oss_device_context_s {
 	int		state[nitems(mixer_state_id)];
 	uint32_t	dev_index;
+	int		fd; /* Mixer device, opened on dev_init(). -1 - closed. */
+	int		is_read_only; /* fd opened with O_RDONLY. */
+	int		modify_counter; /* mixer_info.modify_counter */
+	int		modify_counter_valid;
 } oss_dev_ctx_t, *oss_dev_ctx_p;
 
 
@@ -280,11 +288,13 @@ device_descr_get(size_t dev_idx, char *buf, size_t buf_size) {
 	snprintf(dev_path, sizeof(dev_path), PATH_DEV_MIXER"%zu",
 	    dev_idx);
 	int fd = open(dev_path, O_RDONLY);
-	if (0 == ioctl(fd, SOUND_MIXER_INFO, &mi)) {
-		strncpy(buf, mi.name, buf_size);
-		tmp = (buf_size - 1);
+	if (-1 != fd) {
+		if (0 == ioctl(fd, SOUND_MIXER_INFO, &mi)) {
+			strncpy(buf, mi.name, buf_size);
+			tmp = (buf_size - 1);
+		}
+		close(fd);
 	}
-	close(fd);
 #endif
 	buf[tmp] = 0x00;
 }
@@ -311,6 +321,7 @@ oss_list_devs(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
 		if (NULL == dev_ctx)
 			return (ENOMEM);
 		dev_ctx->dev_index = (uint32_t)i;
+		dev_ctx->fd = -1;
 		dev.priv = dev_ctx;
 		error = gmp_dev_list_add(plugin, dev_list, &dev);
 		if (0 != error) {
@@ -374,30 +385,80 @@ oss_is_list_devs_changed(gm_plugin_p plugin) {
 }
 
 
+static int
+oss_dev_open(gmp_dev_p dev) {
+	oss_dev_ctx_p dev_ctx = dev->priv;
+
+	if (-1 != dev_ctx->fd)
+		return (0);
+	dev_ctx->is_read_only = 0;
+	dev_ctx->fd = open(dev->name, (O_RDWR | O_CLOEXEC));
+	if (-1 == dev_ctx->fd && EACCES == errno) { /* Read only access. */
+		dev_ctx->is_read_only = 1;
+		dev_ctx->fd = open(dev->name, (O_RDONLY | O_CLOEXEC));
+	}
+	if (-1 == dev_ctx->fd)
+		return (errno);
+	dev_ctx->modify_counter_valid = 0;
+
+	return (0);
+}
+
+static void
+oss_dev_close(gmp_dev_p dev) {
+	oss_dev_ctx_p dev_ctx = dev->priv;
+
+	if (-1 == dev_ctx->fd)
+		return;
+	close(dev_ctx->fd);
+	dev_ctx->fd = -1;
+}
+
+/* ioctl() on cached mixer fd, reopen device once if it was
+ * disconnected and connected back. */
+static int
+oss_dev_ioctl(gmp_dev_p dev, const unsigned long req, void *arg) {
+	int error;
+	oss_dev_ctx_p dev_ctx = dev->priv;
+
+	for (size_t retry = 0;; retry ++) {
+		error = oss_dev_open(dev);
+		if (0 != error)
+			return (error);
+		if (-1 != ioctl(dev_ctx->fd, req, arg))
+			return (0);
+		error = errno;
+		if (0 != retry ||
+		    (ENODEV != error && EBADF != error && ENXIO != error))
+			return (error);
+		/* Write on read only fd: reopen will not help. */
+		if (EBADF == error && 0 != dev_ctx->is_read_only)
+			return (error);
+		oss_dev_close(dev);
+	}
+}
+
 static int
 oss_dev_init(gmp_dev_p dev) {
-	int error, fd, chan_mask;
+	int error, chan_mask;
 	oss_dev_ctx_p dev_ctx;
 	gmp_dev_line_p dev_line;
 
-	if (NULL == dev)
+	if (NULL == dev || NULL == dev->priv)
 		return (EINVAL);
 
 	dev_ctx = dev->priv;
 
 	/* State, caps, settings. */
-	fd = open(dev->name, O_RDONLY);
-	if (-1 == fd) {
-		error = errno;
-		goto err_out;
-	}
+	error = oss_dev_open(dev);
+	if (0 != error)
+		return (error);
 	for (size_t i = 0; i < nitems(mixer_state_id); i ++) {
-		if (-1 == ioctl(fd, MIXER_READ(mixer_state_id[i]),
+		if (0 != oss_dev_ioctl(dev, MIXER_READ(mixer_state_id[i]),
 		    &dev_ctx->state[i])) {
 			dev_ctx->state[i] = 0;
 		}
 	}
-	close(fd);
 
 	/* Lines / channels add. */
 	for (size_t i = 0; i < SOUND_MIXER_NRDEVICES; i ++) {
@@ -410,14 +471,14 @@ oss_dev_init(gmp_dev_p dev) {
 		if (0 != error)
 			goto err_out;
 		dev_line->priv = (void*)i; /* Store line index. */
-		dev_line->chan_map = (((uint32_t)1) << MIXER_CHANNEL_FL);
+		dev_line->chan_map = (((uint64_t)1) << MIXER_CHANNEL_FL);
 		dev_line->chan_vol_count = 1;
 		if (0 != (chan_mask & dev_ctx->state[MIXER_STATE_STEREODEVS])) {
-			dev_line->chan_map |= (((uint32_t)1) << MIXER_CHANNEL_FR);
+			dev_line->chan_map |= (((uint64_t)1) << MIXER_CHANNEL_FR);
 			dev_line->chan_vol_count ++;
 		}
 		dev_line->is_capture = (0 != (chan_mask & dev_ctx->state[MIXER_STATE_RECMASK]));
-		dev_line->is_read_only = 0;
+		dev_line->is_read_only = dev_ctx->is_read_only;
 		/* All rec lines can be disabled. */
 		dev_line->has_enable = dev_line->is_capture;
 	}
@@ -425,17 +486,49 @@ oss_dev_init(gmp_dev_p dev) {
 	return (0);
 
 err_out:
-	free(dev_ctx);
+	oss_dev_close(dev);
 
 	return (error);
 }
 
+static void
+oss_dev_uninit(gmp_dev_p dev) {
+
+	if (NULL == dev || NULL == dev->priv)
+		return;
+	oss_dev_close(dev);
+}
+
+static int
+oss_dev_is_changed(gmp_dev_p dev) {
+	oss_dev_ctx_p dev_ctx;
+	mixer_info mi;
+
+	if (NULL == dev || NULL == dev->priv)
+		return (1);
+
+	dev_ctx = dev->priv;
+	/* Driver increment modify_counter on every mixer write. */
+	if (0 != oss_dev_ioctl(dev, SOUND_MIXER_INFO, &mi)) {
+		dev_ctx->modify_counter_valid = 0;
+		return (1);
+	}
+	if (0 != dev_ctx->modify_counter_valid &&
+	    mi.modify_counter == dev_ctx->modify_counter)
+		return (0);
+	dev_ctx->modify_counter = mi.modify_counter;
+	dev_ctx->modify_counter_valid = 1;
+
+	return (1);
+}
+
 static void
 oss_dev_destroy(gmp_dev_p dev) {
 
-	if (NULL == dev)
+	if (NULL == dev || NULL == dev->priv)
 		return;
 
+	oss_dev_close(dev);
 	free(dev->priv);
 	dev->priv = NULL;
 }
@@ -479,10 +572,35 @@ oss_dev_set_default(gmp_dev_p dev, const uint32_t type) {
 #endif
 
 
+static void
+oss_vol_to_app(oss_dev_ctx_p dev_ctx, const int chan_mask, const int vol,
+    gmp_dev_line_state_p line_state) {
+
+	/* Left channel: first in chan_vol[]. */
+	line_state->chan_vol[0] = (vol & 0x7f);
+	/* Right channel. */
+	if (0 != (chan_mask & dev_ctx->state[MIXER_STATE_STEREODEVS])) {
+		line_state->chan_vol[1] = ((vol >> 8) & 0x7f);
+	}
+}
+
+static int
+oss_vol_from_app(oss_dev_ctx_p dev_ctx, const int chan_mask,
+    gmp_dev_line_state_p line_state) {
+	int vol;
+
+	vol = line_state->chan_vol[0];
+	if (0 != (chan_mask & dev_ctx->state[MIXER_STATE_STEREODEVS])) {
+		vol |= (line_state->chan_vol[1] << 8);
+	}
+
+	return (vol);
+}
+
 static int
 oss_dev_line_read(gmp_dev_p dev, gmp_dev_line_p dev_line,
     gmp_dev_line_state_p line_state) {
-	int error = 0, fd, chan_mask, vol;
+	int error, chan_mask, vol;
 	size_t chan_idx;
 	oss_dev_ctx_p dev_ctx;
 
@@ -495,45 +613,31 @@ oss_dev_line_read(gmp_dev_p dev, gmp_dev_line_p dev_line,
 	if (0 == (chan_mask & dev_ctx->state[MIXER_STATE_DEVMASK]))
 		return (EINVAL);
 
-	/* Read state. */
-	fd = open(dev->name, O_RDONLY);
-	if (-1 == fd)
-		return (errno);
 	/* Volume level. */
-	if (-1 == ioctl(fd, MIXER_READ(chan_idx), &vol)) {
-		error = errno;
-		goto err_out;
-	}
+	error = oss_dev_ioctl(dev, MIXER_READ(chan_idx), &vol);
+	if (0 != error)
+		return (error);
 	/* Map OSS to app values. */
-	/* Left channel. */
-	line_state->chan_vol[MIXER_CHANNEL_FL] = (vol & 0x7f);
-	/* Right channel. */
-	if (0 != (chan_mask & dev_ctx->state[MIXER_STATE_STEREODEVS])) {
-		line_state->chan_vol[MIXER_CHANNEL_FR] = ((vol >> 8) & 0x7f);
-	}
+	oss_vol_to_app(dev_ctx, chan_mask, vol, line_state);
 	/* Enabled state. */
 	if (dev_line->is_capture) {
-		if (-1 == ioctl(fd,
+		error = oss_dev_ioctl(dev,
 		    MIXER_READ(mixer_state_id[MIXER_STATE_RECSRC]),
-		    &dev_ctx->state[MIXER_STATE_RECSRC])) {
-			error = errno;
-			goto err_out;
-		}
+		    &dev_ctx->state[MIXER_STATE_RECSRC]);
+		if (0 != error)
+			return (error);
 		/* Map OSS to app values. */
 		line_state->is_enabled = (0 != (chan_mask &
 		    dev_ctx->state[MIXER_STATE_RECSRC]));
 	}
 
-err_out:
-	close(fd);
-
-	return (error);
+	return (0);
 }
 
 static int
 oss_dev_line_write(gmp_dev_p dev, gmp_dev_line_p dev_line,
     gmp_dev_line_state_p line_state) {
-	int error = 0, fd, chan_mask, vol;
+	int error, chan_mask, vol;
 	size_t chan_idx;
 	oss_dev_ctx_p dev_ctx;
 
@@ -547,19 +651,11 @@ oss_dev_line_write(gmp_dev_p dev, gmp_dev_line_p dev_line,
 		return (EINVAL);
 
 	/* Map app to OSS values. */
-	vol = line_state->chan_vol[MIXER_CHANNEL_FL];
-	if (0 != (chan_mask & dev_ctx->state[MIXER_STATE_STEREODEVS])) {
-		vol |= (line_state->chan_vol[MIXER_CHANNEL_FR] << 8);
-	}
-	/* Write state. */
-	fd = open(dev->name, O_RDWR);
-	if (-1 == fd)
-		return (errno);
+	vol = oss_vol_from_app(dev_ctx, chan_mask, line_state);
 	/* Volume level. */
-	if (-1 == ioctl(fd, MIXER_WRITE(chan_idx), &vol)) {
-		error = errno;
-		goto err_out;
-	}
+	error = oss_dev_ioctl(dev, MIXER_WRITE(chan_idx), &vol);
+	if (0 != error)
+		return (error);
 	/* Enabled state. */
 	if (dev_line->is_capture) {
 		/* Map OSS to app values. */
@@ -568,28 +664,133 @@ oss_dev_line_write(gmp_dev_p dev, gmp_dev_line_p dev_line,
 		} else {
 			dev_ctx->state[MIXER_STATE_RECSRC] &= ~chan_mask;
 		}
-		if (-1 == ioctl(fd,
+		error = oss_dev_ioctl(dev,
 		    MIXER_WRITE(mixer_state_id[MIXER_STATE_RECSRC]),
-		    &dev_ctx->state[MIXER_STATE_RECSRC])) {
-			error = errno;
-			goto err_out;
-		}
+		    &dev_ctx->state[MIXER_STATE_RECSRC]);
+		if (0 != error)
+			return (error);
 		/* Read to ensure that it got aplly. */
-		if (-1 == ioctl(fd,
+		error = oss_dev_ioctl(dev,
 		    MIXER_READ(mixer_state_id[MIXER_STATE_RECSRC]),
-		    &dev_ctx->state[MIXER_STATE_RECSRC])) {
-			error = errno;
-			goto err_out;
-		}
+		    &dev_ctx->state[MIXER_STATE_RECSRC]);
+		if (0 != error)
+			return (error);
 		/* Map OSS to app values. */
 		line_state->is_enabled = (0 != (chan_mask &
 		    dev_ctx->state[MIXER_STATE_RECSRC]));
 	}
 
-err_out:
-	close(fd);
+	return (0);
+}
 
-	return (error);
+/* Batch read: record sources state is read once for all lines. */
+static int
+oss_dev_read_all(gmp_dev_p dev, const size_t *lines_mask,
+    gmp_dev_line_state_p line_states) {
+	int error, chan_mask, vol, recsrc_read = 0;
+	size_t chan_idx;
+	oss_dev_ctx_p dev_ctx;
+	gmp_dev_line_p dev_line;
+
+	if (NULL == dev || NULL == dev->priv || NULL == lines_mask ||
+	    NULL == line_states)
+		return (EINVAL);
+
+	dev_ctx = dev->priv;
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		if (0 == GMP_LINES_MASK_IS_SET(lines_mask, i))
+			continue;
+		dev_line = gmp_dev_line_get(dev, i);
+		chan_idx = ((size_t)dev_line->priv);
+		chan_mask = (((int)1) << chan_idx);
+		if (0 == (chan_mask & dev_ctx->state[MIXER_STATE_DEVMASK]))
+			return (EINVAL);
+		/* Volume level. */
+		error = oss_dev_ioctl(dev, MIXER_READ(chan_idx), &vol);
+		if (0 != error)
+			return (error);
+		oss_vol_to_app(dev_ctx, chan_mask, vol, &line_states[i]);
+		/* Enabled state. */
+		if (0 == dev_line->is_capture)
+			continue;
+		if (0 == recsrc_read) {
+			error = oss_dev_ioctl(dev,
+			    MIXER_READ(mixer_state_id[MIXER_STATE_RECSRC]),
+			    &dev_ctx->state[MIXER_STATE_RECSRC]);
+			if (0 != error)
+				return (error);
+			recsrc_read = 1;
+		}
+		line_states[i].is_enabled = (0 != (chan_mask &
+		    dev_ctx->state[MIXER_STATE_RECSRC]));
+	}
+
+	return (0);
+}
+
+/* Batch write: record sources state is written once for all lines. */
+static int
+oss_dev_write_batch(gmp_dev_p dev, const size_t *lines_mask,
+    gmp_dev_line_state_p line_states) {
+	int error, chan_mask, vol, recsrc_write = 0;
+	size_t chan_idx;
+	oss_dev_ctx_p dev_ctx;
+	gmp_dev_line_p dev_line;
+
+	if (NULL == dev || NULL == dev->priv || NULL == lines_mask ||
+	    NULL == line_states)
+		return (EINVAL);
+
+	dev_ctx = dev->priv;
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		if (0 == GMP_LINES_MASK_IS_SET(lines_mask, i))
+			continue;
+		dev_line = gmp_dev_line_get(dev, i);
+		chan_idx = ((size_t)dev_line->priv);
+		chan_mask = (((int)1) << chan_idx);
+		if (0 == (chan_mask & dev_ctx->state[MIXER_STATE_DEVMASK]))
+			return (EINVAL);
+		/* Volume level. */
+		vol = oss_vol_from_app(dev_ctx, chan_mask, &line_states[i]);
+		error = oss_dev_ioctl(dev, MIXER_WRITE(chan_idx), &vol);
+		if (0 != error)
+			return (error);
+		/* Enabled state. */
+		if (0 == dev_line->is_capture)
+			continue;
+		if (0 != line_states[i].is_enabled) {
+			dev_ctx->state[MIXER_STATE_RECSRC] |= chan_mask;
+		} else {
+			dev_ctx->state[MIXER_STATE_RECSRC] &= ~chan_mask;
+		}
+		recsrc_write = 1;
+	}
+	if (0 == recsrc_write)
+		return (0);
+
+	error = oss_dev_ioctl(dev,
+	    MIXER_WRITE(mixer_state_id[MIXER_STATE_RECSRC]),
+	    &dev_ctx->state[MIXER_STATE_RECSRC]);
+	if (0 != error)
+		return (error);
+	/* Read to ensure that it got aplly. */
+	error = oss_dev_ioctl(dev,
+	    MIXER_READ(mixer_state_id[MIXER_STATE_RECSRC]),
+	    &dev_ctx->state[MIXER_STATE_RECSRC]);
+	if (0 != error)
+		return (error);
+	/* Map OSS to app values. */
+	for (size_t i = 0; i < dev->lines_count; i ++) {
+		if (0 == GMP_LINES_MASK_IS_SET(lines_mask, i) ||
+		    0 == gmp_dev_line_get(dev, i)->is_capture)
+			continue;
+		dev_line = gmp_dev_line_get(dev, i);
+		chan_mask = (((int)1) << ((size_t)dev_line->priv));
+		line_states[i].is_enabled = (0 != (chan_mask &
+		    dev_ctx->state[MIXER_STATE_RECSRC]));
+	}
+
+	return (0);
 }
 
 const gmp_descr_t plugin_oss3 = {
@@ -606,8 +807,15 @@ const gmp_descr_t plugin_oss3 = {
 	.uninit		= oss_uninit,
 	.list_devs	= oss_list_devs,
 	.is_list_devs_changed= oss_is_list_devs_changed,
+	.hotplug_nodes	= oss_hotplug_nodes,
+	.notify		= GMP_NOTIFY_DEVS,
+	.poll_cost	= GMP_POLL_COST_LOW, /* modify_counter: 1 ioctl. */
 	.dev_init	= oss_dev_init,
+	.dev_uninit	= oss_dev_uninit,
 	.dev_destroy	= oss_dev_destroy,
+	.dev_is_changed	= oss_dev_is_changed,
 	.dev_line_read	= oss_dev_line_read,
 	.dev_line_write	= oss_dev_line_write,
+	.dev_read_all	= oss_dev_read_all,
+	.dev_write_batch= oss_dev_write_batch,
 };
@@ -0,0 +1,1228 @@
+/*-
+ * Copyright (c) 2026 Rozhuk Ivan <rozhuk.im@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: Rozhuk Ivan <rozhuk.im@gmail.com>
+ *
+ */
+
+/*
+ * Backend I/O worker: one thread per plugin.
+ * GUI thread pass commands and get results via lock free single
+ * producer / single consumer queues, pipes are used only for wakeup.
+ * Snapshots are filled by one side and then passed to other as is.
+ * All plugin calls, from worker and from GUI thread, are serialized by
+ * recursive io_lock, so plugins does not need to be thread safe.
+ * GUI thread only try lock it: devices lists scan and devices destroy
+ * are done by worker too.
+ */
+
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "plugin_api.h"
+
+
+#define GMP_WQ_SIZE		64 /* Must be power of 2. */
+#define GMP_WORKER_STOP_TIMEOUT	1000 /* ms, pending writes on exit. */
+
+#define GMP_WMSG_CHECK		1 /* List devs / default dev changes. */
+#define GMP_WMSG_DEV_READ	2
+#define GMP_WMSG_DEV_WRITE	3
+#define GMP_WMSG_DEV_EVENTS	4 /* Result only: read after events. */
+#define GMP_WMSG_EVENTS_ERROR	5 /* Result only: events detached. */
+#define GMP_WMSG_DEV_INIT	6
+#define GMP_WMSG_DEV_UNINIT	7
+#define GMP_WMSG_DEV_SET_DEFAULT 8
+#define GMP_WMSG_LIST		9 /* Scan devices list. */
+#define GMP_WMSG_DEVS_DESTROY	10
+
+typedef struct gtk_mixer_plugin_worker_msg_s {
+	uint32_t	type; /* GMP_WMSG_*. */
+	int		error;
+	int		force; /* Read: all lines, check: list devs too. */
+	int		list_changed;
+	int		def_changed;
+	uint32_t	def_type; /* Set default: DEV_IS_*. */
+	uint64_t	gen; /* Attached device generation. */
+	uint64_t	epoch; /* Devices epoch: dev valid if not changed. */
+	gmp_dev_p	dev; /* Init: compared with init_dev before use. */
+	gmp_dev_snapshot_p snap; /* Owned by device. */
+	gmp_dev_list_p	dev_list; /* List: result, owned by receiver. */
+	gmp_worker_trash_p trash; /* Result: devices left attached. */
+} gmp_worker_msg_t, *gmp_worker_msg_p;
+
+/* Attached device snap_events state. */
+#define GMP_EVSNAP_FREE		0
+#define GMP_EVSNAP_BUSY		1 /* Passed to GUI. */
+#define GMP_EVSNAP_MISSED	2 /* Busy, events lines left in read_mask. */
+
+/* Lock free single producer / single consumer ring. */
+typedef struct gtk_mixer_plugin_worker_queue_s {
+	_Atomic size_t	head; /* Producer position. */
+	_Atomic size_t	tail; /* Consumer position. */
+	gmp_worker_msg_t msgs[GMP_WQ_SIZE];
+} gmp_wq_t, *gmp_wq_p;
+
+typedef struct gtk_mixer_plugin_worker_s {
+	gm_plugin_p	plugin;
+	pthread_t	thread;
+	pthread_mutex_t	io_lock; /* Serialize plugin calls. */
+	gmp_wq_t	cmds; /* GUI -> worker. */
+	gmp_wq_t	results; /* Worker -> GUI. */
+	int		cmd_fd[2]; /* Worker wakeup pipe. */
+	int		res_fd[2]; /* GUI wakeup pipe. */
+	_Atomic int	running;
+	_Atomic int	exited; /* Thread done, can be joined. */
+	_Atomic uint64_t call_start; /* Plugin call start time, us, 0 - idle. */
+	/* Set by GUI thread with io_lock held. */
+	gmp_dev_p	dev; /* Attached device. */
+	uint64_t	dev_gen; /* Changed on each attach/detach. */
+	struct pollfd	*pfds; /* Device events descriptors. */
+	size_t		pfds_count;
+	int		events_attached;
+	/* Device to init, set by GUI thread, cleared with io_lock held. */
+	_Atomic(gmp_dev_p) init_dev;
+	_Atomic int	events_snap; /* GMP_EVSNAP_*. */
+	/* Worker thread only. */
+	struct pollfd	*poll_set; /* Wakeup pipe + pfds. */
+	size_t		poll_set_size;
+	/* GUI thread only. */
+	gmp_dev_p	attach_dev; /* Attach request, dev if done. */
+	int		abandoned; /* Hung on stop: not joined. */
+	int		read_pending; /* Read requested while busy. */
+	int		read_pending_force;
+	int		list_pending; /* List requested while busy. */
+	uint64_t	devs_epoch; /* Changed on devices set member destroy. */
+	gmp_worker_trash_p trash; /* Not sent yet. */
+	/* Requests in progress. */
+	size_t		lists_inflight;
+	size_t		checks_inflight;
+	size_t		reads_inflight;
+	size_t		writes_inflight;
+} gmp_worker_t;
+
+
+static inline uint64_t
+gmp_worker_time_usec(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((((uint64_t)ts.tv_sec) * 1000000) +
+	    (((uint64_t)ts.tv_nsec) / 1000));
+}
+
+static int
+gmp_wq_push(gmp_wq_p wq, const gmp_worker_msg_t *msg) {
+	size_t head = atomic_load_explicit(&wq->head, memory_order_relaxed);
+
+	if (GMP_WQ_SIZE == (head - atomic_load_explicit(&wq->tail,
+	    memory_order_acquire)))
+		return (EAGAIN); /* Full. */
+	wq->msgs[(head & (GMP_WQ_SIZE - 1))] = (*msg);
+	atomic_store_explicit(&wq->head, (head + 1), memory_order_release);
+
+	return (0);
+}
+
+static int
+gmp_wq_pop(gmp_wq_p wq, gmp_worker_msg_p msg) {
+	size_t tail = atomic_load_explicit(&wq->tail, memory_order_relaxed);
+
+	if (tail == atomic_load_explicit(&wq->head, memory_order_acquire))
+		return (EAGAIN); /* Empty. */
+	(*msg) = wq->msgs[(tail & (GMP_WQ_SIZE - 1))];
+	atomic_store_explicit(&wq->tail, (tail + 1), memory_order_release);
+
+	return (0);
+}
+
+static int
+gmp_worker_pipe(int *fds) {
+
+	if (0 != pipe(fds))
+		return (errno);
+	for (size_t i = 0; i < 2; i ++) {
+		if (-1 == fcntl(fds[i], F_SETFL, O_NONBLOCK) ||
+		    -1 == fcntl(fds[i], F_SETFD, FD_CLOEXEC))
+			return (errno);
+	}
+
+	return (0);
+}
+
+static void
+gmp_worker_wakeup(const int fd) {
+
+	if (-1 == write(fd, "", 1)) {
+		/* Pipe full: wakeup already pending. */
+	}
+}
+
+static void
+gmp_worker_wakeup_drain(const int fd) {
+	char buf[64];
+
+	while (0 < read(fd, buf, sizeof(buf)))
+		;
+}
+
+static inline void
+gmp_worker_call_begin(gmp_worker_p worker) {
+
+	atomic_store(&worker->call_start, gmp_worker_time_usec());
+}
+
+static inline void
+gmp_worker_call_end(gmp_worker_p worker) {
+
+	atomic_store(&worker->call_start, 0);
+}
+
+/* Destroy trash devices except attached: it is left until GUI detach it.
+ * Return non zero if trash is empty and freed. */
+static int
+gmp_worker_trash_destroy(gmp_worker_trash_p trash, gmp_dev_p attached) {
+	size_t i, j;
+
+	gmp_dev_list_clear(trash->dev_list);
+	free(trash->dev_list);
+	trash->dev_list = NULL;
+	for (i = 0, j = 0; i < trash->devs_count; i ++) {
+		if (attached == trash->devs[i]) {
+			trash->devs[j ++] = trash->devs[i];
+			continue;
+		}
+		gmp_dev_destroy(trash->devs[i]);
+		free(trash->devs[i]);
+	}
+	trash->devs_count = j;
+	if (0 != j)
+		return (0);
+	free(trash);
+
+	return (1);
+}
+
+
+/* Worker thread. */
+static void
+gmp_worker_result(gmp_worker_p worker, gmp_worker_msg_p msg) {
+
+	/* Results are not dropped: GUI count requests in progress. */
+	while (0 != gmp_wq_push(&worker->results, msg)) {
+		if (0 == atomic_load(&worker->running))
+			return;
+		usleep(1000);
+	}
+	gmp_worker_wakeup(worker->res_fd[1]);
+}
+
+static void
+gmp_worker_cmd(gmp_worker_p worker, gmp_worker_msg_p msg) {
+	gm_plugin_p plugin = worker->plugin;
+
+	switch (msg->type) {
+	case GMP_WMSG_CHECK:
+		gmp_worker_call_begin(worker);
+		if (0 != msg->force) {
+			msg->list_changed =
+			    gmp_plugin_is_list_devs_changed(plugin);
+		}
+		msg->def_changed = gmp_plugin_is_def_dev_changed(plugin);
+		gmp_worker_call_end(worker);
+		break;
+	case GMP_WMSG_DEV_READ:
+		pthread_mutex_lock(&worker->io_lock);
+		if (NULL == worker->dev ||
+		    msg->gen != worker->dev_gen) {
+			msg->error = ENODEV; /* Detached. */
+		} else {
+			gmp_worker_call_begin(worker);
+			msg->error = gmp_dev_snapshot_read(worker->dev,
+			    msg->snap, msg->force, NULL);
+			gmp_worker_call_end(worker);
+		}
+		pthread_mutex_unlock(&worker->io_lock);
+		break;
+	case GMP_WMSG_DEV_WRITE:
+		pthread_mutex_lock(&worker->io_lock);
+		/* Device destroy is queued after: it is valid here. */
+		if (NULL == msg->dev->read_mask) {
+			msg->error = ENODEV; /* Uninitialized. */
+		} else {
+			gmp_worker_call_begin(worker);
+			msg->error = gmp_dev_snapshot_write(msg->dev,
+			    msg->snap);
+			gmp_worker_call_end(worker);
+		}
+		pthread_mutex_unlock(&worker->io_lock);
+		break;
+	case GMP_WMSG_DEV_INIT:
+		pthread_mutex_lock(&worker->io_lock);
+		/* Device may be already destroyed: compare pointer only. */
+		if (msg->dev != atomic_load(&worker->init_dev)) {
+			msg->error = ECANCELED;
+		} else {
+			gmp_worker_call_begin(worker);
+			msg->error = gmp_dev_init(msg->dev);
+			if (GMP_DEV_INIT_DONE !=
+			    atomic_load(&msg->dev->init_state)) {
+				msg->dev->init_error = msg->error;
+				atomic_store(&msg->dev->init_state,
+				    GMP_DEV_INIT_ERROR);
+			}
+			gmp_worker_call_end(worker);
+		}
+		pthread_mutex_unlock(&worker->io_lock);
+		break;
+	case GMP_WMSG_DEV_UNINIT:
+		pthread_mutex_lock(&worker->io_lock);
+		if (msg->dev == worker->dev) {
+			/* Attached again: stay initialized. */
+			msg->error = EBUSY;
+			if (NULL != msg->dev->read_mask) {
+				atomic_store(&msg->dev->init_state,
+				    GMP_DEV_INIT_DONE);
+			}
+		} else {
+			gmp_worker_call_begin(worker);
+			gmp_dev_uninit(msg->dev);
+			gmp_worker_call_end(worker);
+		}
+		pthread_mutex_unlock(&worker->io_lock);
+		break;
+	case GMP_WMSG_DEV_SET_DEFAULT:
+		gmp_worker_call_begin(worker);
+		msg->error = gmp_dev_set_default(msg->dev, msg->def_type);
+		gmp_worker_call_end(worker);
+		msg->def_changed = 1;
+		break;
+	case GMP_WMSG_LIST:
+		msg->dev_list = calloc(1, sizeof(gmp_dev_list_t));
+		if (NULL == msg->dev_list) {
+			msg->error = ENOMEM;
+			break;
+		}
+		gmp_worker_call_begin(worker);
+		msg->error = gmp_plugin_list_devs(plugin, msg->dev_list);
+		if (0 != msg->error) {
+			gmp_dev_list_clear(msg->dev_list);
+			free(msg->dev_list);
+			msg->dev_list = NULL;
+		}
+		gmp_worker_call_end(worker);
+		break;
+	case GMP_WMSG_DEVS_DESTROY:
+		pthread_mutex_lock(&worker->io_lock);
+		gmp_worker_call_begin(worker);
+		if (0 != gmp_worker_trash_destroy(msg->trash, worker->dev)) {
+			msg->trash = NULL;
+		}
+		gmp_worker_call_end(worker);
+		pthread_mutex_unlock(&worker->io_lock);
+		break;
+	default:
+		msg->error = EINVAL;
+		break;
+	}
+	gmp_worker_result(worker, msg);
+}
+
+static void
+gmp_worker_dev_events(gmp_worker_p worker, const uint64_t gen,
+    struct pollfd *pfds, const size_t pfds_count) {
+	int error, state;
+	size_t i, lines_read = 0;
+	gmp_worker_msg_t msg;
+
+	for (i = 0; i < pfds_count; i ++) {
+		if (0 != pfds[i].revents)
+			break;
+	}
+	if (i == pfds_count)
+		return; /* No events. */
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_DEV_EVENTS;
+	msg.gen = gen;
+	pthread_mutex_lock(&worker->io_lock);
+	if (NULL == worker->dev || gen != worker->dev_gen) {
+		/* Detached, descriptors may be already closed. */
+		pthread_mutex_unlock(&worker->io_lock);
+		return;
+	}
+	gmp_worker_call_begin(worker);
+	error = gmp_dev_handle_events(worker->dev, pfds, pfds_count);
+	if (0 == error) {
+		/* Snapshot not applied by GUI yet: it will request read. */
+		state = atomic_load(&worker->events_snap);
+		while (0 == atomic_compare_exchange_weak(&worker->events_snap,
+		    &state, ((GMP_EVSNAP_FREE == state) ?
+		    GMP_EVSNAP_BUSY : GMP_EVSNAP_MISSED)))
+			;
+		if (GMP_EVSNAP_FREE == state) {
+			msg.snap = worker->dev->snap_events;
+			gmp_dev_snapshot_read(worker->dev, msg.snap, 0,
+			    &lines_read);
+			if (0 == lines_read) {
+				atomic_store(&worker->events_snap,
+				    GMP_EVSNAP_FREE);
+			}
+		}
+	} else { /* Fallback to polling by timer. */
+		msg.type = GMP_WMSG_EVENTS_ERROR;
+		msg.error = error;
+		worker->pfds_count = 0;
+	}
+	gmp_worker_call_end(worker);
+	pthread_mutex_unlock(&worker->io_lock);
+
+	if (GMP_WMSG_DEV_EVENTS == msg.type &&
+	    0 == lines_read)
+		return; /* Nothing to report. */
+	gmp_worker_result(worker, &msg);
+}
+
+static void *
+gmp_worker_thread(void *arg) {
+	gmp_worker_p worker = arg;
+	uint64_t gen;
+	size_t poll_count;
+	struct pollfd *poll_set;
+	gmp_worker_msg_t msg;
+
+	while (0 != atomic_load(&worker->running)) {
+		/* Poll set: wakeup pipe + attached device events. */
+		pthread_mutex_lock(&worker->io_lock);
+		gen = worker->dev_gen;
+		poll_count = (worker->pfds_count + 1);
+		if (worker->poll_set_size < poll_count) {
+			poll_set = reallocarray(worker->poll_set, poll_count,
+			    sizeof(struct pollfd));
+			if (NULL != poll_set) {
+				worker->poll_set = poll_set;
+				worker->poll_set_size = poll_count;
+			}
+		}
+		poll_count = MIN(poll_count, worker->poll_set_size);
+		poll_set = worker->poll_set;
+		memcpy(&poll_set[1], worker->pfds,
+		    ((poll_count - 1) * sizeof(struct pollfd)));
+		pthread_mutex_unlock(&worker->io_lock);
+		poll_set[0].fd = worker->cmd_fd[0];
+		poll_set[0].events = POLLIN;
+
+		if (-1 == poll(poll_set, (nfds_t)poll_count, -1)) {
+			if (EINTR == errno)
+				continue;
+			break;
+		}
+		if (0 != poll_set[0].revents) {
+			gmp_worker_wakeup_drain(worker->cmd_fd[0]);
+			while (0 != atomic_load(&worker->running) &&
+			    0 == gmp_wq_pop(&worker->cmds, &msg)) {
+				gmp_worker_cmd(worker, &msg);
+			}
+		}
+		if (1 < poll_count) {
+			gmp_worker_dev_events(worker, gen, &poll_set[1],
+			    (poll_count - 1));
+		}
+	}
+	/* Changes made by user must be written before exit,
+	 * devices destroyed after. */
+	while (0 == gmp_wq_pop(&worker->cmds, &msg)) {
+		if (GMP_WMSG_DEV_WRITE != msg.type &&
+		    GMP_WMSG_DEVS_DESTROY != msg.type)
+			continue;
+		gmp_worker_cmd(worker, &msg);
+	}
+	atomic_store(&worker->exited, 1);
+
+	return (NULL);
+}
+
+
+/* GUI thread. */
+static int
+gmp_worker_send(gmp_worker_p worker, const gmp_worker_msg_t *msg) {
+	int error;
+
+	error = gmp_wq_push(&worker->cmds, msg);
+	if (0 != error)
+		return (error);
+	gmp_worker_wakeup(worker->cmd_fd[1]);
+
+	return (0);
+}
+
+int
+gmp_worker_start(gm_plugin_p plugin) {
+	int error;
+	gmp_worker_p worker;
+	pthread_mutexattr_t attr;
+
+	if (NULL == plugin)
+		return (-1);
+	if (NULL != plugin->worker)
+		return (plugin->worker->res_fd[0]);
+
+	worker = calloc(1, sizeof(gmp_worker_t));
+	if (NULL == worker)
+		return (-1);
+	worker->plugin = plugin;
+	worker->cmd_fd[0] = worker->cmd_fd[1] = -1;
+	worker->res_fd[0] = worker->res_fd[1] = -1;
+	atomic_init(&worker->cmds.head, 0);
+	atomic_init(&worker->cmds.tail, 0);
+	atomic_init(&worker->results.head, 0);
+	atomic_init(&worker->results.tail, 0);
+	atomic_init(&worker->call_start, 0);
+	atomic_init(&worker->running, 1);
+	atomic_init(&worker->exited, 0);
+	atomic_init(&worker->init_dev, NULL);
+	atomic_init(&worker->events_snap, GMP_EVSNAP_FREE);
+	worker->poll_set = calloc(1, sizeof(struct pollfd));
+	if (NULL == worker->poll_set)
+		goto err_out;
+	worker->poll_set_size = 1;
+	if (0 != gmp_worker_pipe(worker->cmd_fd) ||
+	    0 != gmp_worker_pipe(worker->res_fd))
+		goto err_out;
+	if (0 != pthread_mutexattr_init(&attr))
+		goto err_out;
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	error = pthread_mutex_init(&worker->io_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	if (0 != error)
+		goto err_out;
+	/* Must be set before thread start: used by gmp_plugin_lock(). */
+	plugin->worker = worker;
+	if (0 != pthread_create(&worker->thread, NULL, gmp_worker_thread,
+	    worker)) {
+		plugin->worker = NULL;
+		pthread_mutex_destroy(&worker->io_lock);
+		goto err_out;
+	}
+
+	return (worker->res_fd[0]);
+
+err_out:
+	for (size_t i = 0; i < 2; i ++) {
+		if (-1 != worker->cmd_fd[i]) {
+			close(worker->cmd_fd[i]);
+		}
+		if (-1 != worker->res_fd[i]) {
+			close(worker->res_fd[i]);
+		}
+	}
+	free(worker->poll_set);
+	free(worker);
+
+	return (-1);
+}
+
+int
+gmp_worker_stop(gm_plugin_p plugin) {
+	gmp_worker_p worker;
+	gmp_worker_trash_p trash;
+	gmp_worker_msg_t msg;
+
+	if (NULL == plugin || NULL == plugin->worker)
+		return (0);
+
+	worker = plugin->worker;
+	if (0 != worker->abandoned)
+		return (ETIMEDOUT);
+	/* Changes made while write was in progress are sent on its
+	 * completion. Stalled worker is not waited: it may never return. */
+	for (size_t i = 0; 0 == plugin->is_stalled &&
+	    0 != worker->writes_inflight &&
+	    i < GMP_WORKER_STOP_TIMEOUT; i ++) {
+		usleep(1000);
+		gmp_worker_handle_results(plugin);
+	}
+	atomic_store(&worker->running, 0);
+	gmp_worker_wakeup(worker->cmd_fd[1]);
+	for (size_t i = 0; 0 == plugin->is_stalled &&
+	    0 == atomic_load(&worker->exited) &&
+	    i < GMP_WORKER_STOP_TIMEOUT; i ++) {
+		usleep(1000);
+	}
+	if (0 == atomic_load(&worker->exited)) {
+		/* Worker, its lock and plugin are left to process exit. */
+		pthread_detach(worker->thread);
+		worker->abandoned = 1;
+		return (ETIMEDOUT);
+	}
+	pthread_join(worker->thread, NULL);
+	plugin->worker = NULL;
+
+	/* Plugin is called from this thread now. */
+	while (0 == gmp_wq_pop(&worker->results, &msg)) {
+		if (NULL != msg.dev_list) {
+			gmp_dev_list_clear(msg.dev_list);
+			free(msg.dev_list);
+		}
+		if (NULL != msg.trash) {
+			gmp_worker_trash_destroy(msg.trash, NULL);
+		}
+	}
+	while (NULL != worker->trash) {
+		trash = worker->trash;
+		worker->trash = trash->next;
+		gmp_worker_trash_destroy(trash, NULL);
+	}
+
+	pthread_mutex_destroy(&worker->io_lock);
+	for (size_t i = 0; i < 2; i ++) {
+		close(worker->cmd_fd[i]);
+		close(worker->res_fd[i]);
+	}
+	free(worker->pfds);
+	free(worker->poll_set);
+	free(worker);
+
+	return (0);
+}
+
+void
+gmp_plugin_lock(gm_plugin_p plugin) {
+
+	if (NULL == plugin || NULL == plugin->worker)
+		return;
+	pthread_mutex_lock(&plugin->worker->io_lock);
+}
+
+void
+gmp_plugin_unlock(gm_plugin_p plugin) {
+
+	if (NULL == plugin || NULL == plugin->worker)
+		return;
+	pthread_mutex_unlock(&plugin->worker->io_lock);
+}
+
+/* io_lock must be held. */
+static void
+gmp_worker_dev_detach_locked(gmp_worker_p worker) {
+
+	worker->dev = NULL;
+	worker->dev_gen ++;
+	worker->pfds_count = 0;
+	worker->events_attached = 0;
+	/* Rebuild poll set. */
+	gmp_worker_wakeup(worker->cmd_fd[1]);
+}
+
+/* Apply attach_dev if io_lock is free: worker may be busy or stalled
+ * in plugin call. Return non zero if attached device changed. */
+static int
+gmp_worker_dev_attach_try(gmp_worker_p worker) {
+	size_t pfds_count;
+	struct pollfd *pfds;
+	gmp_dev_p dev = worker->attach_dev;
+
+	if (dev == worker->dev)
+		return (0); /* Nothing to do. */
+	if (0 != pthread_mutex_trylock(&worker->io_lock))
+		return (0); /* Retried on results handle. */
+	gmp_worker_dev_detach_locked(worker);
+	if (NULL != dev) {
+		worker->dev = dev;
+		pfds_count = gmp_dev_poll_descriptors(dev, NULL, 0);
+		if (0 != pfds_count) {
+			pfds = reallocarray(worker->pfds, pfds_count,
+			    sizeof(struct pollfd));
+			if (NULL != pfds) {
+				worker->pfds = pfds;
+				worker->pfds_count = gmp_dev_poll_descriptors(
+				    dev, pfds, pfds_count);
+			}
+		}
+		worker->events_attached = (0 != worker->pfds_count);
+	}
+	pthread_mutex_unlock(&worker->io_lock);
+
+	return (1);
+}
+
+int
+gmp_worker_dev_attach(gmp_dev_p dev) {
+
+	if (NULL == dev || NULL == dev->plugin->worker)
+		return (0);
+
+	dev->plugin->worker->attach_dev = dev;
+	gmp_worker_dev_attach_try(dev->plugin->worker);
+
+	return (gmp_worker_dev_events_attached(dev));
+}
+
+void
+gmp_worker_dev_detach(gmp_dev_p dev) {
+	gmp_worker_p worker;
+	gmp_dev_p init_dev = dev;
+
+	if (NULL == dev || NULL == dev->plugin->worker)
+		return;
+
+	worker = dev->plugin->worker;
+	if (dev == worker->attach_dev) {
+		worker->attach_dev = NULL;
+		gmp_worker_dev_attach_try(worker);
+	}
+	/* Queued init will be skipped. */
+	atomic_compare_exchange_strong(&worker->init_dev, &init_dev, NULL);
+}
+
+void
+gmp_worker_dev_release(gmp_dev_p dev) {
+	gmp_worker_p worker;
+	gmp_dev_p init_dev = dev;
+
+	if (NULL == dev || NULL == dev->plugin->worker)
+		return;
+
+	worker = dev->plugin->worker;
+	/* Worker thread does not uninit attached device. */
+	if (dev == worker->dev) {
+		gmp_worker_dev_detach_locked(worker);
+	}
+	/* Queued init will be skipped. */
+	atomic_compare_exchange_strong(&worker->init_dev, &init_dev, NULL);
+}
+
+void
+gmp_worker_dev_destroy(gmp_dev_p dev) {
+	gmp_worker_p worker;
+	gmp_dev_p init_dev = dev;
+
+	if (NULL == dev || NULL == dev->plugin->worker)
+		return;
+
+	worker = dev->plugin->worker;
+	if (dev == worker->attach_dev) {
+		worker->attach_dev = NULL;
+		gmp_worker_dev_attach_try(worker);
+	}
+	/* Queued init will be skipped. */
+	atomic_compare_exchange_strong(&worker->init_dev, &init_dev, NULL);
+	worker->devs_epoch ++;
+}
+
+gmp_worker_trash_p
+gmp_worker_trash_alloc(const size_t devs_count) {
+
+	return (calloc(1, (sizeof(gmp_worker_trash_t) +
+	    (devs_count * sizeof(gmp_dev_p)))));
+}
+
+/* Send pending trash in order. */
+static void
+gmp_worker_trash_send(gmp_worker_p worker) {
+	gmp_worker_trash_p trash;
+	gmp_worker_msg_t msg;
+
+	while (NULL != (trash = worker->trash)) {
+		memset(&msg, 0x00, sizeof(msg));
+		msg.type = GMP_WMSG_DEVS_DESTROY;
+		msg.trash = trash;
+		if (0 != gmp_worker_send(worker, &msg))
+			return; /* Queue full: retried on results. */
+		worker->trash = trash->next;
+		trash->next = NULL;
+	}
+}
+
+void
+gmp_worker_trash_put(gm_plugin_p plugin, gmp_worker_trash_p trash) {
+	gmp_worker_trash_p *next;
+
+	if (NULL == plugin || NULL == trash)
+		return;
+	if (NULL == plugin->worker) {
+		gmp_worker_trash_destroy(trash, NULL);
+		return;
+	}
+	if (0 == trash->devs_count &&
+	    (NULL == trash->dev_list || 0 == trash->dev_list->count)) {
+		/* Nothing to destroy by plugin. */
+		gmp_worker_trash_destroy(trash, NULL);
+		return;
+	}
+	/* Destroyed in order. */
+	for (next = &plugin->worker->trash; NULL != (*next);
+	    next = &(*next)->next)
+		;
+	(*next) = trash;
+	gmp_worker_trash_send(plugin->worker);
+}
+
+void
+gmp_worker_dev_list_destroy(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+	gmp_worker_trash_p trash;
+
+	if (NULL == plugin || NULL == dev_list)
+		return;
+	trash = gmp_worker_trash_alloc(0);
+	if (NULL == trash) {
+		/* Scan data is not used by requests: safe to destroy here. */
+		gmp_dev_list_clear(dev_list);
+		free(dev_list);
+		return;
+	}
+	trash->dev_list = dev_list;
+	gmp_worker_trash_put(plugin, trash);
+}
+
+int
+gmp_worker_dev_events_attached(gmp_dev_p dev) {
+
+	if (NULL == dev || NULL == dev->plugin->worker ||
+	    dev != dev->plugin->worker->dev)
+		return (0);
+
+	return (dev->plugin->worker->events_attached);
+}
+
+int
+gmp_dev_init_async(gmp_dev_p dev) {
+	int error;
+	gmp_worker_p worker;
+	gmp_worker_msg_t msg;
+
+	if (NULL == dev)
+		return (EINVAL);
+	worker = dev->plugin->worker;
+	if (NULL == worker)
+		return (gmp_dev_init(dev));
+	if (dev == atomic_load(&worker->init_dev))
+		return (EINPROGRESS);
+
+	/* No lock: worker may be busy. */
+	switch (atomic_load(&dev->init_state)) {
+	case GMP_DEV_INIT_DONE:
+		return (0);
+	case GMP_DEV_INIT_ERROR: /* Report once. */
+		error = dev->init_error;
+		atomic_store(&dev->init_state, GMP_DEV_INIT_NONE);
+		return (error);
+	}
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_DEV_INIT;
+	msg.dev = dev;
+	/* Cancel previous request. */
+	atomic_store(&worker->init_dev, dev);
+	error = gmp_worker_send(worker, &msg);
+	if (0 != error) {
+		atomic_compare_exchange_strong(&worker->init_dev, &dev, NULL);
+		return (error);
+	}
+
+	return (EINPROGRESS);
+}
+
+int
+gmp_dev_uninit_async(gmp_dev_p dev) {
+	int error;
+	gmp_worker_p worker;
+	gmp_worker_msg_t msg;
+	gmp_dev_p init_dev = dev;
+
+	if (NULL == dev)
+		return (EINVAL);
+	worker = dev->plugin->worker;
+	if (NULL == worker) {
+		gmp_dev_uninit(dev);
+		return (0);
+	}
+	/* Queued init will be skipped. */
+	atomic_compare_exchange_strong(&worker->init_dev, &init_dev, NULL);
+	if (GMP_DEV_INIT_DONE != atomic_load(&dev->init_state))
+		return (0);
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_DEV_UNINIT;
+	msg.dev = dev;
+	/* Next init request will be queued after uninit. */
+	atomic_store(&dev->init_state, GMP_DEV_INIT_NONE);
+	error = gmp_worker_send(worker, &msg);
+	if (0 != error) { /* Stay initialized. */
+		atomic_store(&dev->init_state, GMP_DEV_INIT_DONE);
+		return (error);
+	}
+
+	return (0);
+}
+
+int
+gmp_dev_read_async(gmp_dev_p dev, int force) {
+	int error;
+	gmp_worker_p worker;
+	gmp_worker_msg_t msg;
+
+	if (NULL == dev)
+		return (EINVAL);
+	worker = dev->plugin->worker;
+	if (NULL == worker)
+		return (gmp_dev_read(dev, force));
+	if (dev != worker->dev && dev != worker->attach_dev)
+		return (ENODEV); /* Attach not requested. */
+	if (dev != worker->dev || /* Attach in progress. */
+	    0 != worker->reads_inflight) {
+		/* Sent by gmp_worker_handle_results() when done. */
+		worker->read_pending = 1;
+		worker->read_pending_force |= force;
+		return (EBUSY);
+	}
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_DEV_READ;
+	msg.force = force;
+	msg.gen = worker->dev_gen;
+	msg.snap = dev->snap_read;
+	error = gmp_worker_send(worker, &msg);
+	if (0 != error)
+		return (error);
+	worker->reads_inflight ++;
+
+	return (0);
+}
+
+int
+gmp_dev_write_async(gmp_dev_p dev) {
+	int error;
+	gmp_worker_p worker;
+	gmp_worker_msg_t msg;
+
+	if (NULL == dev)
+		return (EINVAL);
+	worker = dev->plugin->worker;
+	if (NULL == worker)
+		return (gmp_dev_write(dev, 0));
+	if (GMP_DEV_INIT_DONE != atomic_load(&dev->init_state))
+		return (ENODEV);
+	/* Only one write in progress: rest will be written on its
+	 * completion with latest values. */
+	if (0 != worker->writes_inflight)
+		return (EBUSY);
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_DEV_WRITE;
+	msg.dev = dev;
+	msg.epoch = worker->devs_epoch;
+	msg.snap = dev->snap_write;
+	if (0 == gmp_dev_snapshot_write_prepare(dev, msg.snap, 0))
+		return (0); /* Nothing to write. */
+	error = gmp_worker_send(worker, &msg);
+	if (0 != error)
+		return (error);
+	worker->writes_inflight ++;
+
+	return (0);
+}
+
+int
+gmp_dev_set_default_async(gmp_dev_p dev, const uint32_t type) {
+	gmp_worker_p worker;
+	gmp_worker_msg_t msg;
+
+	if (NULL == dev)
+		return (EINVAL);
+	worker = dev->plugin->worker;
+	if (NULL == worker)
+		return (gmp_dev_set_default(dev, type));
+
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_DEV_SET_DEFAULT;
+	msg.def_type = type;
+	msg.dev = dev;
+
+	return (gmp_worker_send(worker, &msg));
+}
+
+void
+gmp_check_async(gm_plugin_p plugins, const size_t plugins_count) {
+	gm_plugin_p plugin;
+	gmp_worker_msg_t msg;
+
+	if (NULL == plugins)
+		return;
+
+	for (size_t i = 0; i < plugins_count; i ++) {
+		plugin = &plugins[i];
+		if (NULL == plugin->worker ||
+		    0 != plugin->worker->checks_inflight ||
+		    0 == gmp_plugin_is_poll_required(plugin))
+			continue;
+		memset(&msg, 0x00, sizeof(msg));
+		msg.type = GMP_WMSG_CHECK;
+		/* Hotplug watcher report devices list changes. */
+		msg.force = (0 == plugin->hotplug_watched);
+		if (0 != gmp_worker_send(plugin->worker, &msg))
+			continue;
+		plugin->worker->checks_inflight ++;
+	}
+}
+
+static void
+gmp_worker_list_send(gmp_worker_p worker) {
+	gmp_worker_msg_t msg;
+
+	/* Changes made while list in progress: scan again on its
+	 * completion. */
+	worker->list_pending = 1;
+	if (0 != worker->lists_inflight)
+		return;
+	memset(&msg, 0x00, sizeof(msg));
+	msg.type = GMP_WMSG_LIST;
+	if (0 != gmp_worker_send(worker, &msg))
+		return;
+	worker->list_pending = 0;
+	worker->lists_inflight ++;
+}
+
+/* Replace not applied list. */
+static void
+gmp_worker_dev_list_set(gm_plugin_p plugin, gmp_dev_list_p dev_list) {
+
+	gmp_worker_dev_list_destroy(plugin, plugin->dev_list);
+	plugin->dev_list = dev_list;
+}
+
+int
+gmp_list_devs_async(gm_plugin_p plugins, const size_t plugins_count) {
+	int error, ret = 0;
+	gm_plugin_p plugin;
+	gmp_dev_list_p dev_list;
+
+	if (NULL == plugins)
+		return (EINVAL);
+
+	for (size_t i = 0; i < plugins_count; i ++) {
+		plugin = &plugins[i];
+		if (NULL != plugin->worker) {
+			gmp_worker_list_send(plugin->worker);
+			continue;
+		}
+		dev_list = calloc(1, sizeof(gmp_dev_list_t));
+		if (NULL == dev_list) {
+			ret = ENOMEM;
+			continue;
+		}
+		error = gmp_plugin_list_devs(plugin, dev_list);
+		if (0 != error) {
+			gmp_dev_list_clear(dev_list);
+			free(dev_list);
+			ret = error;
+			continue;
+		}
+		gmp_worker_dev_list_set(plugin, dev_list);
+	}
+
+	return (ret);
+}
+
+uint32_t
+gmp_worker_handle_results(gm_plugin_p plugin) {
+	int force;
+	uint32_t ret = 0;
+	gmp_worker_p worker;
+	gmp_worker_msg_t msg;
+	gmp_dev_p dev;
+
+	if (NULL == plugin || NULL == plugin->worker)
+		return (0);
+
+	worker = plugin->worker;
+	/* Drain wakeups before queue: no lost results. */
+	gmp_worker_wakeup_drain(worker->res_fd[0]);
+	/* Attach was deferred by busy worker. */
+	if (0 != gmp_worker_dev_attach_try(worker)) {
+		ret |= GMP_WORKER_RES_EVENTS;
+	}
+	while (0 == gmp_wq_pop(&worker->results, &msg)) {
+		/* Results for detached device are ignored. */
+		dev = ((msg.gen == worker->dev_gen) ? worker->dev : NULL);
+		switch (msg.type) {
+		case GMP_WMSG_CHECK:
+			worker->checks_inflight --;
+			plugin->worker_list_changed |= msg.list_changed;
+			plugin->worker_def_changed |= msg.def_changed;
+			ret |= GMP_WORKER_RES_CHECK;
+			break;
+		case GMP_WMSG_DEV_READ:
+			worker->reads_inflight --;
+			if (NULL == dev || 0 != msg.error)
+				break;
+			if (0 != gmp_dev_snapshot_read_apply(dev, msg.snap)) {
+				ret |= GMP_WORKER_RES_LINES;
+			}
+			break;
+		case GMP_WMSG_DEV_EVENTS:
+			if (NULL != dev &&
+			    0 != gmp_dev_snapshot_read_apply(dev, msg.snap)) {
+				ret |= GMP_WORKER_RES_LINES;
+			}
+			/* Snapshot can be reused by worker. */
+			if (GMP_EVSNAP_MISSED == atomic_exchange(
+			    &worker->events_snap, GMP_EVSNAP_FREE) &&
+			    NULL != worker->dev) {
+				gmp_dev_read_async(worker->dev, 0);
+			}
+			break;
+		case GMP_WMSG_DEV_WRITE:
+			worker->writes_inflight --;
+			/* Device may be destroyed or uninitialized after
+			 * request, it must not be used then. Snapshot is
+			 * freed by uninit. */
+			if (msg.epoch == worker->devs_epoch &&
+			    GMP_DEV_INIT_DONE ==
+			    atomic_load(&msg.dev->init_state) &&
+			    msg.snap == msg.dev->snap_write) {
+				gmp_dev_snapshot_write_apply(msg.dev, msg.snap);
+				if (0 != msg.error && msg.dev == worker->dev) {
+					/* Show actual mixer state. */
+					gmp_dev_read_async(msg.dev, 1);
+				}
+				/* Changes made while write was in progress. */
+				gmp_dev_write_async(msg.dev);
+			}
+			if (NULL != worker->dev && msg.dev != worker->dev) {
+				gmp_dev_write_async(worker->dev);
+			}
+			break;
+		case GMP_WMSG_EVENTS_ERROR:
+			if (NULL == dev)
+				break;
+			worker->events_attached = 0;
+			ret |= GMP_WORKER_RES_EVENTS;
+			break;
+		case GMP_WMSG_DEV_INIT:
+			/* Done: gmp_dev_init_async() report state. */
+			if (ECANCELED != msg.error) {
+				atomic_compare_exchange_strong(
+				    &worker->init_dev, &msg.dev, NULL);
+			}
+			ret |= GMP_WORKER_RES_INIT;
+			break;
+		case GMP_WMSG_DEV_SET_DEFAULT:
+			/* Default flags are updated by list. */
+			plugin->worker_def_changed |= msg.def_changed;
+			ret |= GMP_WORKER_RES_CHECK;
+			break;
+		case GMP_WMSG_LIST:
+			worker->lists_inflight --;
+			if (0 != msg.error)
+				break;
+			gmp_worker_dev_list_set(plugin, msg.dev_list);
+			ret |= GMP_WORKER_RES_LIST;
+			break;
+		case GMP_WMSG_DEVS_DESTROY:
+			if (NULL == msg.trash)
+				break;
+			/* Attached device left: detach is retried on
+			 * results handle, then sent again. */
+			msg.trash->next = worker->trash;
+			worker->trash = msg.trash;
+			break;
+		}
+	}
+	/* List requested while previous list in progress. */
+	if (0 != worker->list_pending &&
+	    0 == worker->lists_inflight) {
+		gmp_worker_list_send(worker);
+	}
+	gmp_worker_trash_send(worker);
+	/* Read requested while attach or previous read in progress. */
+	if (0 != worker->read_pending &&
+	    0 == worker->reads_inflight &&
+	    NULL != worker->dev) {
+		force = worker->read_pending_force;
+		worker->read_pending = 0;
+		worker->read_pending_force = 0;
+		gmp_dev_read_async(worker->dev, force);
+	}
+
+	return (ret);
+}
+
+size_t
+gmp_worker_watchdog(gm_plugin_p plugins, const size_t plugins_count,
+    const uint64_t timeout) {
+	size_t ret = 0;
+	int is_stalled;
+	uint64_t call_start, now;
+	gm_plugin_p plugin;
+
+	if (NULL == plugins)
+		return (0);
+
+	now = gmp_worker_time_usec();
+	for (size_t i = 0; i < plugins_count; i ++) {
+		plugin = &plugins[i];
+		if (NULL == plugin->worker)
+			continue;
+		call_start = atomic_load(&plugin->worker->call_start);
+		is_stalled = (0 != call_start &&
+		    timeout < (now - call_start));
+		plugin->is_stalled = is_stalled;
+		ret += (size_t)is_stalled;
+	}
+
+	return (ret);
+}
+
+int
+gmp_worker_is_busy(gm_plugin_p plugins, const size_t plugins_count) {
+	gmp_worker_p worker;
+
+	if (NULL == plugins)
+		return (0);
+
+	for (size_t i = 0; i < plugins_count; i ++) {
+		worker = plugins[i].worker;
+		if (NULL == worker)
+			continue;
+		if (0 != atomic_load(&worker->call_start) ||
+		    atomic_load(&worker->cmds.head) !=
+		    atomic_load(&worker->cmds.tail))
+			return (1);
+	}
+
+	return (0);
+}
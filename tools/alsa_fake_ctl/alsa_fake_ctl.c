@@ -0,0 +1,417 @@
+/*-
+ * Copyright (c) 2026 Rozhuk Ivan <rozhuk.im@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: Rozhuk Ivan <rozhuk.im@gmail.com>
+ *
+ */
+
+/*
+ * Fake ALSA sound card: external control plugin with synthetic mixer
+ * elements. Used to measure ALSA backend without sound hardware.
+ * Config (see gen-asoundrc.sh):
+ * ctl.NAME {
+ *	type gmfake
+ *	lines 32		Lines count, each: "* Volume" + "* Switch".
+ *	channels 2		Channels per line.
+ *	min 0			Volume range.
+ *	max 255
+ *	capture 8		Last N lines are capture lines.
+ *	latency_us 0		Delay on each element read/write.
+ *	events_hz 0		External changes rate.
+ * }
+ */
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/timerfd.h>
+#include <alsa/asoundlib.h>
+#include <alsa/control_external.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef __unused
+#	define __unused		__attribute__((__unused__))
+#endif
+
+#define GMFAKE_CHANNELS_MAX	32
+/* 2 elements per line: volume and switch. */
+#define GMFAKE_KEY_LINE(__key)	((__key) / 2)
+#define GMFAKE_KEY_IS_SW(__key)	(0 != ((__key) & 1))
+
+
+typedef struct gmfake_line_s {
+	long		vol[GMFAKE_CHANNELS_MAX];
+	int		sw;
+} gmfake_line_t, *gmfake_line_p;
+
+typedef struct gmfake_ctl_s {
+	snd_ctl_ext_t	ext;
+	size_t		lines_count;
+	size_t		capture_count;
+	unsigned int	channels;
+	long		vol_min;
+	long		vol_max;
+	long		latency_us;
+	long		events_hz;
+	uint64_t	events_pending;
+	size_t		event_line; /* Next line to change. */
+	gmfake_line_p	lines;
+} gmfake_ctl_t, *gmfake_ctl_p;
+
+
+static void
+gmfake_latency(gmfake_ctl_p fake) {
+	struct timespec ts;
+
+	if (0 >= fake->latency_us)
+		return;
+	ts.tv_sec = (fake->latency_us / 1000000);
+	ts.tv_nsec = ((fake->latency_us % 1000000) * 1000);
+	nanosleep(&ts, NULL);
+}
+
+static void
+gmfake_elem_id_set(gmfake_ctl_p fake, const size_t key,
+    snd_ctl_elem_id_t *id) {
+	size_t line = GMFAKE_KEY_LINE(key);
+	const int is_capture = (line >= (fake->lines_count - fake->capture_count));
+	char name[SNDRV_CTL_ELEM_ID_NAME_MAXLEN];
+
+	snprintf(name, sizeof(name), "Fake %zu %s %s", line,
+	    ((is_capture) ? "Capture" : "Playback"),
+	    ((GMFAKE_KEY_IS_SW(key)) ? "Switch" : "Volume"));
+	snd_ctl_elem_id_set_interface(id, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_id_set_name(id, name);
+	snd_ctl_elem_id_set_index(id, 0);
+}
+
+
+static void
+gmfake_close(snd_ctl_ext_t *ext) {
+	gmfake_ctl_p fake = ext->private_data;
+
+	if (-1 != ext->poll_fd) {
+		close(ext->poll_fd);
+	}
+	free(fake->lines);
+	free(fake);
+}
+
+static int
+gmfake_elem_count(snd_ctl_ext_t *ext) {
+	gmfake_ctl_p fake = ext->private_data;
+
+	return ((int)(fake->lines_count * 2));
+}
+
+static int
+gmfake_elem_list(snd_ctl_ext_t *ext, unsigned int offset,
+    snd_ctl_elem_id_t *id) {
+	gmfake_ctl_p fake = ext->private_data;
+
+	if (offset >= (fake->lines_count * 2))
+		return (-EINVAL);
+	gmfake_elem_id_set(fake, offset, id);
+
+	return (0);
+}
+
+static snd_ctl_ext_key_t
+gmfake_find_elem(snd_ctl_ext_t *ext, const snd_ctl_elem_id_t *id) {
+	gmfake_ctl_p fake = ext->private_data;
+	const char *name;
+	char *end;
+	unsigned long line;
+	snd_ctl_ext_key_t key;
+
+	name = snd_ctl_elem_id_get_name(id);
+	if (0 != strncmp(name, "Fake ", 5))
+		return (SND_CTL_EXT_KEY_NOT_FOUND);
+	line = strtoul(&name[5], &end, 10);
+	if (line >= fake->lines_count)
+		return (SND_CTL_EXT_KEY_NOT_FOUND);
+	key = (line * 2);
+	if (NULL != strstr(end, " Switch")) {
+		key ++;
+	}
+
+	return (key);
+}
+
+static int
+gmfake_get_attribute(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+    int *type, unsigned int *acc, unsigned int *count) {
+	gmfake_ctl_p fake = ext->private_data;
+
+	if (key >= (fake->lines_count * 2))
+		return (-EINVAL);
+	(*type) = ((GMFAKE_KEY_IS_SW(key)) ? SND_CTL_ELEM_TYPE_BOOLEAN :
+	    SND_CTL_ELEM_TYPE_INTEGER);
+	(*acc) = SND_CTL_EXT_ACCESS_READWRITE;
+	(*count) = ((GMFAKE_KEY_IS_SW(key)) ? 1 : fake->channels);
+
+	return (0);
+}
+
+static int
+gmfake_get_integer_info(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key __unused,
+    long *imin, long *imax, long *istep) {
+	gmfake_ctl_p fake = ext->private_data;
+
+	(*imin) = fake->vol_min;
+	(*imax) = fake->vol_max;
+	(*istep) = 1;
+
+	return (0);
+}
+
+static int
+gmfake_read_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+    long *value) {
+	gmfake_ctl_p fake = ext->private_data;
+	gmfake_line_p line;
+
+	if (key >= (fake->lines_count * 2))
+		return (-EINVAL);
+	gmfake_latency(fake);
+	line = &fake->lines[GMFAKE_KEY_LINE(key)];
+	if (GMFAKE_KEY_IS_SW(key)) {
+		value[0] = line->sw;
+		return (0);
+	}
+	memcpy(value, line->vol, (sizeof(long) * fake->channels));
+
+	return (0);
+}
+
+static int
+gmfake_write_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+    long *value) {
+	gmfake_ctl_p fake = ext->private_data;
+	gmfake_line_p line;
+
+	if (key >= (fake->lines_count * 2))
+		return (-EINVAL);
+	gmfake_latency(fake);
+	line = &fake->lines[GMFAKE_KEY_LINE(key)];
+	if (GMFAKE_KEY_IS_SW(key)) {
+		if (line->sw == (0 != value[0]))
+			return (0);
+		line->sw = (0 != value[0]);
+		return (1); /* Changed. */
+	}
+	if (0 == memcmp(line->vol, value, (sizeof(long) * fake->channels)))
+		return (0);
+	for (unsigned int i = 0; i < fake->channels; i ++) {
+		line->vol[i] = MAX(fake->vol_min, MIN(fake->vol_max, value[i]));
+	}
+
+	return (1); /* Changed. */
+}
+
+static void
+gmfake_subscribe_events(snd_ctl_ext_t *ext, int subscribe) {
+	gmfake_ctl_p fake = ext->private_data;
+	struct itimerspec its;
+
+	memset(&its, 0x00, sizeof(its));
+	if (0 != subscribe && 0 < fake->events_hz) {
+		its.it_interval.tv_sec = (1 / fake->events_hz);
+		its.it_interval.tv_nsec = ((1000000000 / fake->events_hz) %
+		    1000000000);
+		its.it_value = its.it_interval;
+	}
+	timerfd_settime(ext->poll_fd, 0, &its, NULL);
+	fake->events_pending = 0;
+}
+
+/* Each timer expiration emulates volume change on next line
+ * from other application. */
+static int
+gmfake_read_event(snd_ctl_ext_t *ext, snd_ctl_elem_id_t *id,
+    unsigned int *event_mask) {
+	gmfake_ctl_p fake = ext->private_data;
+	uint64_t expirations;
+	gmfake_line_p line;
+
+	if (sizeof(expirations) == read(ext->poll_fd, &expirations,
+	    sizeof(expirations))) {
+		fake->events_pending += expirations;
+	}
+	if (0 == fake->events_pending)
+		return (-EAGAIN);
+	fake->events_pending --;
+
+	fake->event_line = ((fake->event_line + 1) % fake->lines_count);
+	line = &fake->lines[fake->event_line];
+	for (unsigned int i = 0; i < fake->channels; i ++) {
+		line->vol[i] ++;
+		if (line->vol[i] > fake->vol_max) {
+			line->vol[i] = fake->vol_min;
+		}
+	}
+	gmfake_elem_id_set(fake, (fake->event_line * 2), id);
+	(*event_mask) = SND_CTL_EVENT_MASK_VALUE;
+
+	return (1);
+}
+
+static const snd_ctl_ext_callback_t gmfake_ext_callback = {
+	.close			= gmfake_close,
+	.elem_count		= gmfake_elem_count,
+	.elem_list		= gmfake_elem_list,
+	.find_elem		= gmfake_find_elem,
+	.get_attribute		= gmfake_get_attribute,
+	.get_integer_info	= gmfake_get_integer_info,
+	.read_integer		= gmfake_read_integer,
+	.write_integer		= gmfake_write_integer,
+	.subscribe_events	= gmfake_subscribe_events,
+	.read_event		= gmfake_read_event,
+};
+
+
+static int
+gmfake_conf_long(snd_config_t *n, long *val) {
+
+	if (0 > snd_config_get_integer(n, val))
+		return (-EINVAL);
+	if (0 > (*val))
+		return (-EINVAL);
+	return (0);
+}
+
+SND_CTL_PLUGIN_DEFINE_FUNC(gmfake) {
+	int error;
+	long lines = 32, channels = 2, capture = 8;
+	const char *id;
+	snd_config_iterator_t i, next;
+	gmfake_ctl_p fake;
+
+	fake = calloc(1, sizeof(gmfake_ctl_t));
+	if (NULL == fake)
+		return (-ENOMEM);
+	fake->vol_max = 255;
+	fake->ext.poll_fd = -1;
+
+	snd_config_for_each(i, next, conf) {
+		snd_config_t *n = snd_config_iterator_entry(i);
+
+		if (0 > snd_config_get_id(n, &id))
+			continue;
+		if (0 == strcmp(id, "comment") ||
+		    0 == strcmp(id, "type") ||
+		    0 == strcmp(id, "hint"))
+			continue;
+		if (0 == strcmp(id, "lines")) {
+			error = gmfake_conf_long(n, &lines);
+		} else if (0 == strcmp(id, "channels")) {
+			error = gmfake_conf_long(n, &channels);
+		} else if (0 == strcmp(id, "min")) {
+			error = gmfake_conf_long(n, &fake->vol_min);
+		} else if (0 == strcmp(id, "max")) {
+			error = gmfake_conf_long(n, &fake->vol_max);
+		} else if (0 == strcmp(id, "capture")) {
+			error = gmfake_conf_long(n, &capture);
+		} else if (0 == strcmp(id, "latency_us")) {
+			error = gmfake_conf_long(n, &fake->latency_us);
+		} else if (0 == strcmp(id, "events_hz")) {
+			error = gmfake_conf_long(n, &fake->events_hz);
+		} else {
+			SNDERR("Unknown field %s", id);
+			error = -EINVAL;
+		}
+		if (0 != error) {
+			SNDERR("Invalid value for %s", id);
+			goto err_out;
+		}
+	}
+	if (0 == lines || 0 == channels ||
+	    GMFAKE_CHANNELS_MAX < channels ||
+	    fake->vol_min >= fake->vol_max) {
+		SNDERR("Invalid lines/channels/min/max");
+		error = -EINVAL;
+		goto err_out;
+	}
+	fake->lines_count = (size_t)lines;
+	fake->capture_count = MIN((size_t)capture, fake->lines_count);
+	fake->channels = (unsigned int)channels;
+	fake->lines = calloc(fake->lines_count, sizeof(gmfake_line_t));
+	if (NULL == fake->lines) {
+		error = -ENOMEM;
+		goto err_out;
+	}
+	for (size_t j = 0; j < fake->lines_count; j ++) {
+		fake->lines[j].sw = 1;
+		for (unsigned int ch = 0; ch < fake->channels; ch ++) {
+			fake->lines[j].vol[ch] = ((fake->vol_min +
+			    fake->vol_max) / 2);
+		}
+	}
+	/* Events source. */
+	fake->ext.poll_fd = timerfd_create(CLOCK_MONOTONIC,
+	    (TFD_NONBLOCK | TFD_CLOEXEC));
+	if (-1 == fake->ext.poll_fd) {
+		error = -errno;
+		goto err_out;
+	}
+
+	fake->ext.version = SND_CTL_EXT_VERSION;
+	fake->ext.card_idx = 0;
+	strncpy(fake->ext.id, "gmfake", (sizeof(fake->ext.id) - 1));
+	strncpy(fake->ext.driver, "gmfake", (sizeof(fake->ext.driver) - 1));
+	strncpy(fake->ext.name, "GTK-Mixer fake card",
+	    (sizeof(fake->ext.name) - 1));
+	snprintf(fake->ext.longname, sizeof(fake->ext.longname),
+	    "GTK-Mixer fake card: %zu lines x %u channels",
+	    fake->lines_count, fake->channels);
+	strncpy(fake->ext.mixername, "gmfake",
+	    (sizeof(fake->ext.mixername) - 1));
+	fake->ext.callback = &gmfake_ext_callback;
+	fake->ext.private_data = fake;
+
+	error = snd_ctl_ext_create(&fake->ext, name, mode);
+	if (0 > error)
+		goto err_out;
+	(*handlep) = fake->ext.handle;
+
+	return (0);
+
+err_out:
+	if (-1 != fake->ext.poll_fd) {
+		close(fake->ext.poll_fd);
+	}
+	free(fake->lines);
+	free(fake);
+
+	return (error);
+}
+
+SND_CTL_PLUGIN_SYMBOL(gmfake);
@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Generate asoundrc with fake ALSA sound card.
+# Usage: gen-asoundrc.sh path/to/libasound_module_ctl_gmfake.so \
+#	[lines] [channels] [max] [latency_us] [events_hz] > asoundrc
+# Then run: ALSA_CONFIG_PATH=asoundrc ALSA_LIST_VIRTUAL=1 gtk-mixer
+#
+
+if [ -z "$1" ]; then
+	echo "Usage: $0 lib_path [lines] [channels] [max] [latency_us] [events_hz]" 1>&2
+	exit 1
+fi
+
+LIB_PATH="$1"
+LINES="${2:-32}"
+CHANNELS="${3:-2}"
+VOL_MAX="${4:-255}"
+LATENCY_US="${5:-0}"
+EVENTS_HZ="${6:-0}"
+
+
+cat << _EOF_
+</usr/share/alsa/alsa.conf>
+
+ctl_type.gmfake {
+	lib "${LIB_PATH}"
+	open "_snd_ctl_gmfake_open"
+}
+
+ctl.gmfake {
+	type gmfake
+	lines ${LINES}
+	channels ${CHANNELS}
+	min 0
+	max ${VOL_MAX}
+	capture $((LINES / 4))
+	latency_us ${LATENCY_US}
+	events_hz ${EVENTS_HZ}
+}
+
+pcm.gmfake {
+	type null
+	hint {
+		show on
+		description "GTK-Mixer fake card"
+	}
+}
+_EOF_
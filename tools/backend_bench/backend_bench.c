@@ -0,0 +1,402 @@
+/*-
+ * Copyright (c) 2026 Rozhuk Ivan <rozhuk.im@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: Rozhuk Ivan <rozhuk.im@gmail.com>
+ *
+ */
+
+/*
+ * Backend benchmark: measure plugins calls cost without GUI.
+ * Usage: backend_bench [-n iterations] [-p plugin] [-d device]
+ * Per plugin: devices list and list changes check time.
+ * Per device: init (with first read), full read and poll read time.
+ * Each measure also report heap allocations per call: steady state
+ * read, poll and check must not allocate.
+ * ALSA devices are measured with both engines: simple mixer (selem)
+ * and control interface (ctl).
+ * Use with fake ALSA card or fake OSS mixers from tools/.
+ */
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "plugin_api.h"
+
+
+#define BENCH_ITERATIONS	100
+#define BENCH_ALSA_CTL_ENVVAR	"ALSA_CTL_ENGINE_DEVS"
+
+
+typedef struct bench_stat_s {
+	uint64_t	min;
+	uint64_t	max;
+	uint64_t	total;
+	size_t		count;
+	size_t		allocs; /* Heap allocations by all calls. */
+} bench_stat_t, *bench_stat_p;
+
+/* Heap allocations counter: malloc() family is replaced for whole
+ * process, libraries included, real functions are found by dlsym().
+ * Allocations made by dlsym() itself are served from static buffer. */
+typedef void *(*bench_malloc_fn)(size_t);
+typedef void *(*bench_calloc_fn)(size_t, size_t);
+typedef void *(*bench_realloc_fn)(void *, size_t);
+typedef void (*bench_free_fn)(void *);
+
+static struct bench_alloc_s {
+	bench_malloc_fn	malloc;
+	bench_calloc_fn	calloc;
+	bench_realloc_fn realloc;
+	bench_free_fn	free;
+	int		initializing;
+	size_t		count; /* malloc(), calloc(), realloc() calls. */
+	size_t		boot_used;
+	_Alignas(max_align_t) uint8_t boot[4096];
+} bench_alloc;
+
+#define BENCH_ALLOC_IS_BOOT(ptr)					\
+	((const uint8_t*)(ptr) >= bench_alloc.boot &&			\
+	 (const uint8_t*)(ptr) < &bench_alloc.boot[sizeof(bench_alloc.boot)])
+
+typedef struct bench_engine_s {
+	const char	*name;
+	const char	*ctl_devs; /* BENCH_ALSA_CTL_ENVVAR value. */
+} bench_engine_t, *bench_engine_p;
+
+static const bench_engine_t bench_alsa_engines[] = {
+	{ .name = "selem",	.ctl_devs = NULL },
+	{ .name = "ctl",	.ctl_devs = "*" },
+};
+static const bench_engine_t bench_def_engines[] = {
+	{ .name = NULL,		.ctl_devs = NULL },
+};
+
+
+static void
+bench_alloc_init(void) {
+
+	if (NULL != bench_alloc.free ||
+	    0 != bench_alloc.initializing)
+		return;
+	bench_alloc.initializing = 1;
+	bench_alloc.malloc = (bench_malloc_fn)dlsym(RTLD_NEXT, "malloc");
+	bench_alloc.calloc = (bench_calloc_fn)dlsym(RTLD_NEXT, "calloc");
+	bench_alloc.realloc = (bench_realloc_fn)dlsym(RTLD_NEXT, "realloc");
+	bench_alloc.free = (bench_free_fn)dlsym(RTLD_NEXT, "free");
+	bench_alloc.initializing = 0;
+}
+
+static void *
+bench_alloc_boot(const size_t size) {
+	void *ret;
+	const size_t size_aligned = roundup(size, sizeof(max_align_t));
+
+	if ((sizeof(bench_alloc.boot) - bench_alloc.boot_used) <
+	    size_aligned) {
+		errno = ENOMEM;
+		return (NULL);
+	}
+	ret = &bench_alloc.boot[bench_alloc.boot_used];
+	bench_alloc.boot_used += size_aligned;
+
+	return (ret);
+}
+
+void *
+malloc(size_t size) {
+
+	bench_alloc_init();
+	if (NULL == bench_alloc.malloc)
+		return (bench_alloc_boot(size));
+	bench_alloc.count ++;
+
+	return (bench_alloc.malloc(size));
+}
+
+void *
+calloc(size_t nmemb, size_t size) {
+
+	bench_alloc_init();
+	if (NULL == bench_alloc.calloc) {
+		if (0 != size && nmemb > (SIZE_MAX / size)) {
+			errno = ENOMEM;
+			return (NULL);
+		}
+		/* Static buffer is zeroed and never reused. */
+		return (bench_alloc_boot((nmemb * size)));
+	}
+	bench_alloc.count ++;
+
+	return (bench_alloc.calloc(nmemb, size));
+}
+
+void *
+realloc(void *ptr, size_t size) {
+	void *ret;
+
+	bench_alloc_init();
+	if (NULL == bench_alloc.realloc) {
+		errno = ENOMEM;
+		return (NULL);
+	}
+	bench_alloc.count ++;
+	if (!BENCH_ALLOC_IS_BOOT(ptr))
+		return (bench_alloc.realloc(ptr, size));
+	/* Old size is unknown: copy up to buffer end. */
+	ret = bench_alloc.malloc(size);
+	if (NULL == ret)
+		return (NULL);
+	memcpy(ret, ptr, MIN(size, (size_t)(&bench_alloc.boot[
+	    sizeof(bench_alloc.boot)] - (const uint8_t*)ptr)));
+
+	return (ret);
+}
+
+void
+free(void *ptr) {
+
+	if (NULL == ptr || BENCH_ALLOC_IS_BOOT(ptr))
+		return;
+	bench_alloc_init();
+	if (NULL == bench_alloc.free)
+		return;
+	bench_alloc.free(ptr);
+}
+
+
+static uint64_t
+bench_time_usec(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((((uint64_t)ts.tv_sec) * 1000000) +
+	    (((uint64_t)ts.tv_nsec) / 1000));
+}
+
+static void
+bench_stat_add(bench_stat_p stat, const uint64_t time_start,
+    const size_t allocs_start) {
+	const uint64_t time_spent = (bench_time_usec() - time_start);
+
+	stat->allocs += (bench_alloc.count - allocs_start);
+
+	if (0 == stat->count || stat->min > time_spent) {
+		stat->min = time_spent;
+	}
+	if (stat->max < time_spent) {
+		stat->max = time_spent;
+	}
+	stat->total += time_spent;
+	stat->count ++;
+}
+
+static void
+bench_stat_print(const char *name, bench_stat_p stat) {
+
+	if (0 == stat->count)
+		return;
+	printf(", %s: %"PRIu64"/%"PRIu64"/%"PRIu64" us %.2f allocs",
+	    name, stat->min, (stat->total / stat->count), stat->max,
+	    ((double)stat->allocs / (double)stat->count));
+}
+
+
+static int
+bench_dev(gmp_dev_p dev, const bench_engine_t *engine,
+    const size_t iterations) {
+	int error;
+	size_t allocs_start;
+	uint64_t time_start;
+	bench_stat_t init, read, poll;
+
+	memset(&init, 0x00, sizeof(init));
+	memset(&read, 0x00, sizeof(read));
+	memset(&poll, 0x00, sizeof(poll));
+
+	/* ALSA select engine on each dev_init(). */
+	if (NULL == engine->ctl_devs) {
+		unsetenv(BENCH_ALSA_CTL_ENVVAR);
+	} else {
+		setenv(BENCH_ALSA_CTL_ENVVAR, engine->ctl_devs, 1);
+	}
+
+	allocs_start = bench_alloc.count;
+	time_start = bench_time_usec();
+	error = gmp_dev_init(dev);
+	bench_stat_add(&init, time_start, allocs_start);
+	if (0 != error) {
+		fprintf(stderr, "%s: %s: init error: %i - %s\n",
+		    dev->plugin->descr->name, dev->name, error,
+		    strerror(error));
+		gmp_dev_uninit(dev);
+		return (error);
+	}
+	/* All lines: like after external change. */
+	for (size_t i = 0; i < iterations; i ++) {
+		for (size_t j = 0; j < dev->lines_count; j ++) {
+			gmp_dev_line_read_required(gmp_dev_line_get(dev, j));
+		}
+		allocs_start = bench_alloc.count;
+		time_start = bench_time_usec();
+		error = gmp_dev_read(dev, 0);
+		bench_stat_add(&read, time_start, allocs_start);
+		if (0 != error)
+			break;
+	}
+	/* Timer poll without changes. */
+	for (size_t i = 0; i < iterations && 0 == error; i ++) {
+		allocs_start = bench_alloc.count;
+		time_start = bench_time_usec();
+		error = gmp_dev_read(dev, 1);
+		bench_stat_add(&poll, time_start, allocs_start);
+	}
+
+	printf("%s: %s", dev->plugin->descr->name, dev->name);
+	if (NULL != engine->name) {
+		printf(" [%s]", engine->name);
+	}
+	printf(": %zu lines", dev->lines_count);
+	bench_stat_print("init", &init);
+	bench_stat_print("read", &read);
+	bench_stat_print("poll", &poll);
+	printf(".\n");
+
+	gmp_dev_uninit(dev);
+
+	return (error);
+}
+
+static int
+bench_plugin(gm_plugin_p plugin, const char *dev_name,
+    const size_t iterations) {
+	int error;
+	size_t allocs_start;
+	uint64_t time_start;
+	bench_stat_t list, check;
+	gmp_dev_list_t dev_list;
+	const bench_engine_t *engines = bench_def_engines;
+	size_t engines_count = nitems(bench_def_engines);
+
+	memset(&list, 0x00, sizeof(list));
+	memset(&check, 0x00, sizeof(check));
+	memset(&dev_list, 0x00, sizeof(dev_list));
+
+	/* Last list devices are measured. */
+	for (size_t i = 0; i < MAX(iterations, 1); i ++) {
+		gmp_dev_list_clear(&dev_list);
+		allocs_start = bench_alloc.count;
+		time_start = bench_time_usec();
+		error = gmp_list_devs(plugin, 1, &dev_list);
+		bench_stat_add(&list, time_start, allocs_start);
+		if (0 != error) {
+			fprintf(stderr, "%s: list_devs error: %i - %s\n",
+			    plugin->descr->name, error, strerror(error));
+			return (error);
+		}
+	}
+	/* Timer poll without changes. */
+	for (size_t i = 0; i < iterations; i ++) {
+		allocs_start = bench_alloc.count;
+		time_start = bench_time_usec();
+		gmp_plugin_is_list_devs_changed(plugin);
+		bench_stat_add(&check, time_start, allocs_start);
+	}
+	printf("%s: %zu devices", plugin->descr->name, dev_list.count);
+	bench_stat_print("list", &list);
+	bench_stat_print("check", &check);
+	printf(".\n");
+
+	if (0 == strcmp(plugin->descr->name, "ALSA")) {
+		engines = bench_alsa_engines;
+		engines_count = nitems(bench_alsa_engines);
+	}
+	for (size_t i = 0; i < dev_list.count; i ++) {
+		if (NULL != dev_name &&
+		    0 != strcmp(dev_name, dev_list.devs[i].name))
+			continue;
+		for (size_t j = 0; j < engines_count; j ++) {
+			bench_dev(&dev_list.devs[i], &engines[j], iterations);
+		}
+	}
+	gmp_dev_list_clear(&dev_list);
+
+	return (0);
+}
+
+
+int
+main(int argc, char **argv) {
+	int error, ch;
+	size_t plugins_count, iterations = BENCH_ITERATIONS;
+	const char *plugin_name = NULL, *dev_name = NULL;
+	gm_plugin_p plugins;
+
+	while ((ch = getopt(argc, argv, "n:p:d:h")) != -1) {
+		switch (ch) {
+		case 'n':
+			iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			plugin_name = optarg;
+			break;
+		case 'd':
+			dev_name = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n iterations] "
+			    "[-p plugin] [-d device]\n", argv[0]);
+			return (EINVAL);
+		}
+	}
+
+	error = gmp_init(&plugins, &plugins_count);
+	if (0 != error) {
+		fprintf(stderr, "gmp_init error: %i - %s\n",
+		    error, strerror(error));
+		return (error);
+	}
+	/* Print each result as soon as it measured. */
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	printf("Time: min/avg/max, heap allocations per call, "
+	    "%zu iterations.\n", iterations);
+	for (size_t i = 0; i < plugins_count; i ++) {
+		if (NULL != plugin_name &&
+		    0 != strcmp(plugin_name, plugins[i].descr->name))
+			continue;
+		bench_plugin(&plugins[i], dev_name, iterations);
+	}
+	gmp_uninit(plugins, plugins_count);
+
+	return (0);
+}
@@ -0,0 +1,467 @@
+/*-
+ * Copyright (c) 2026 Rozhuk Ivan <rozhuk.im@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: Rozhuk Ivan <rozhuk.im@gmail.com>
+ *
+ */
+
+/*
+ * Fake OSS mixers: LD_PRELOAD library that emulate /dev/mixerN nodes
+ * in memory. Used to measure OSS backend without sound hardware.
+ * Env knobs:
+ *	GMOSS_DEVS		Mixers count, /dev/mixer0 ... /dev/mixer(N-1).
+ *	GMOSS_LINES		Lines count per mixer: 1 - SOUND_MIXER_NRDEVICES.
+ *	GMOSS_LATENCY_US	Delay on each ioctl().
+ *	GMOSS_EVENTS_HZ		External changes rate.
+ * Real /dev/mixerN nodes are hidden.
+ */
+
+/* Both open()/stat() and open64()/stat64() are defined here:
+ * large file redirects would make them same symbols. */
+#undef _FILE_OFFSET_BITS
+
+#include <sys/param.h>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/soundcard.h>
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define GMOSS_PATH		"/dev/mixer"
+#define GMOSS_DEVS_MAX		64
+#define GMOSS_FDS_MAX		1024
+#define GMOSS_EVENTS_MAX	1024 /* Max changes applied per call. */
+#define GMOSS_RECMASK		(SOUND_MASK_LINE | SOUND_MASK_MIC |	\
+				SOUND_MASK_CD | SOUND_MASK_LINE1 |	\
+				SOUND_MASK_LINE2 | SOUND_MASK_LINE3 |	\
+				SOUND_MASK_DIGITAL1 | SOUND_MASK_DIGITAL2 | \
+				SOUND_MASK_DIGITAL3 | SOUND_MASK_PHONEIN | \
+				SOUND_MASK_RADIO | SOUND_MASK_VIDEO)
+#define GMOSS_MONODEVS		(SOUND_MASK_MIC | SOUND_MASK_SPEAKER)
+
+
+typedef struct gmoss_dev_s {
+	int		vol[SOUND_MIXER_NRDEVICES];
+	int		recsrc;
+	int		modify_counter;
+} gmoss_dev_t, *gmoss_dev_p;
+
+typedef struct gmoss_s {
+	size_t		devs_count;
+	int		devmask;
+	int		recmask;
+	int		stereodevs;
+	long		latency_us;
+	long		events_hz;
+	uint64_t	events_start; /* usec */
+	uint64_t	events_done;
+	size_t		event_dev; /* Next dev to change. */
+	size_t		event_line; /* Next line to change. */
+	struct timespec	mtime;
+	gmoss_dev_t	devs[GMOSS_DEVS_MAX];
+	size_t		fd_dev[GMOSS_FDS_MAX]; /* fd -> (dev index + 1). */
+	/* Real functions. */
+	int		(*open)(const char *path, int flags, ...);
+	int		(*open64)(const char *path, int flags, ...);
+	int		(*close)(int fd);
+	int		(*ioctl)(int fd, unsigned long req, ...);
+	int		(*stat)(const char *path, struct stat *st);
+	int		(*stat64)(const char *path, struct stat64 *st);
+} gmoss_t;
+
+static gmoss_t gmoss;
+static pthread_once_t gmoss_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t gmoss_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static uint64_t
+gmoss_time_usec(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((((uint64_t)ts.tv_sec) * 1000000) +
+	    (((uint64_t)ts.tv_nsec) / 1000));
+}
+
+static long
+gmoss_env_long(const char *name, const long def, const long min,
+    const long max) {
+	const char *val = getenv(name);
+	char *end;
+	long ret;
+
+	if (NULL == val || 0 == val[0])
+		return (def);
+	ret = strtol(val, &end, 10);
+	if (0 != end[0])
+		return (def);
+
+	return (MAX(min, MIN(max, ret)));
+}
+
+static void
+gmoss_init(void) {
+	long lines;
+	gmoss_dev_p dev;
+
+	gmoss.open = dlsym(RTLD_NEXT, "open");
+	gmoss.open64 = dlsym(RTLD_NEXT, "open64");
+	gmoss.close = dlsym(RTLD_NEXT, "close");
+	gmoss.ioctl = dlsym(RTLD_NEXT, "ioctl");
+	gmoss.stat = dlsym(RTLD_NEXT, "stat");
+	gmoss.stat64 = dlsym(RTLD_NEXT, "stat64");
+
+	gmoss.devs_count = (size_t)gmoss_env_long("GMOSS_DEVS", 1, 0,
+	    GMOSS_DEVS_MAX);
+	lines = gmoss_env_long("GMOSS_LINES", 8, 1, SOUND_MIXER_NRDEVICES);
+	gmoss.latency_us = gmoss_env_long("GMOSS_LATENCY_US", 0, 0, 1000000);
+	gmoss.events_hz = gmoss_env_long("GMOSS_EVENTS_HZ", 0, 0, 1000000);
+	gmoss.events_start = gmoss_time_usec();
+	clock_gettime(CLOCK_REALTIME, &gmoss.mtime);
+
+	gmoss.devmask = (int)((lines < 31) ?
+	    ((((uint32_t)1) << lines) - 1) : 0x7fffffff);
+	gmoss.recmask = (gmoss.devmask & GMOSS_RECMASK);
+	gmoss.stereodevs = (gmoss.devmask & ~GMOSS_MONODEVS);
+	for (size_t i = 0; i < gmoss.devs_count; i ++) {
+		dev = &gmoss.devs[i];
+		for (size_t j = 0; j < SOUND_MIXER_NRDEVICES; j ++) {
+			dev->vol[j] = (75 | (75 << 8));
+		}
+		/* Lowest record source is enabled. */
+		dev->recsrc = (gmoss.recmask & -gmoss.recmask);
+	}
+}
+
+/* -1 - not fake mixer path, -2 - fake mixer that does not exist,
+ * other - fake mixer index. */
+static ssize_t
+gmoss_path_dev(const char *path) {
+	size_t idx = 0;
+	const char *ptr;
+
+	if (NULL == path ||
+	    0 != strncmp(path, GMOSS_PATH, (sizeof(GMOSS_PATH) - 1)))
+		return (-1);
+	ptr = &path[(sizeof(GMOSS_PATH) - 1)];
+	if (0 == ptr[0])
+		return (-1);
+	for (; 0 != ptr[0]; ptr ++) {
+		if ('0' > ptr[0] || '9' < ptr[0])
+			return (-1);
+		idx = ((idx * 10) + (size_t)(ptr[0] - '0'));
+		if (GMOSS_DEVS_MAX < idx)
+			return (-2);
+	}
+	pthread_once(&gmoss_once, gmoss_init);
+	if (gmoss.devs_count <= idx)
+		return (-2);
+
+	return ((ssize_t)idx);
+}
+
+static void
+gmoss_latency(void) {
+	struct timespec ts;
+
+	if (0 >= gmoss.latency_us)
+		return;
+	ts.tv_sec = (gmoss.latency_us / 1000000);
+	ts.tv_nsec = ((gmoss.latency_us % 1000000) * 1000);
+	nanosleep(&ts, NULL);
+}
+
+/* Emulate external changes: change next line volume on each event. */
+static void
+gmoss_events_apply(void) {
+	uint64_t due;
+	gmoss_dev_p dev;
+	int vol;
+
+	if (0 >= gmoss.events_hz || 0 == gmoss.devs_count)
+		return;
+	due = (((gmoss_time_usec() - gmoss.events_start) *
+	    (uint64_t)gmoss.events_hz) / 1000000);
+	if (GMOSS_EVENTS_MAX < (due - gmoss.events_done)) {
+		gmoss.events_done = (due - GMOSS_EVENTS_MAX);
+	}
+	for (; gmoss.events_done < due; gmoss.events_done ++) {
+		while (0 == (gmoss.devmask & (1 << gmoss.event_line))) {
+			gmoss.event_line = 0;
+			gmoss.event_dev = ((gmoss.event_dev + 1) %
+			    gmoss.devs_count);
+		}
+		dev = &gmoss.devs[gmoss.event_dev];
+		vol = (((dev->vol[gmoss.event_line] & 0x7f) + 7) % 101);
+		dev->vol[gmoss.event_line] = (vol | (vol << 8));
+		dev->modify_counter ++;
+		gmoss.event_line ++;
+	}
+}
+
+static void
+gmoss_stat_fill(const size_t idx, struct stat *st) {
+
+	memset(st, 0x00, sizeof(struct stat));
+	st->st_dev = 5;
+	st->st_ino = (1000 + idx);
+	st->st_mode = (S_IFCHR | 0666);
+	st->st_nlink = 1;
+	st->st_rdev = makedev(14, (idx << 4));
+	st->st_atim = gmoss.mtime;
+	st->st_mtim = gmoss.mtime;
+	st->st_ctim = gmoss.mtime;
+}
+
+static int
+gmoss_open(const ssize_t idx, const int flags) {
+	int fd;
+
+	if (0 > idx) {
+		errno = ENOENT;
+		return (-1);
+	}
+	fd = gmoss.open("/dev/null", (O_RDWR | (O_CLOEXEC & flags)));
+	if (-1 == fd)
+		return (-1);
+	if (GMOSS_FDS_MAX <= fd) {
+		gmoss.close(fd);
+		errno = EMFILE;
+		return (-1);
+	}
+	pthread_mutex_lock(&gmoss_lock);
+	gmoss.fd_dev[fd] = ((size_t)idx + 1);
+	pthread_mutex_unlock(&gmoss_lock);
+
+	return (fd);
+}
+
+static int
+gmoss_ioctl(gmoss_dev_p dev, const unsigned long req, void *arg) {
+	int *val = arg, left, right;
+	const unsigned long nr = (req & 0xff);
+	mixer_info *mi;
+
+	switch (req) {
+	case SOUND_MIXER_INFO:
+		mi = arg;
+		memset(mi, 0x00, sizeof(mixer_info));
+		snprintf(mi->id, sizeof(mi->id), "gmoss%zu",
+		    (size_t)(dev - gmoss.devs));
+		snprintf(mi->name, sizeof(mi->name), "Fake OSS mixer %zu",
+		    (size_t)(dev - gmoss.devs));
+		mi->modify_counter = dev->modify_counter;
+		return (0);
+	case MIXER_READ(SOUND_MIXER_RECSRC):
+		(*val) = dev->recsrc;
+		return (0);
+	case MIXER_WRITE(SOUND_MIXER_RECSRC):
+		dev->recsrc = ((*val) & gmoss.recmask);
+		dev->modify_counter ++;
+		(*val) = dev->recsrc;
+		return (0);
+	case MIXER_READ(SOUND_MIXER_DEVMASK):
+		(*val) = gmoss.devmask;
+		return (0);
+	case MIXER_READ(SOUND_MIXER_RECMASK):
+		(*val) = gmoss.recmask;
+		return (0);
+	case MIXER_READ(SOUND_MIXER_CAPS):
+		(*val) = 0;
+		return (0);
+	case MIXER_READ(SOUND_MIXER_STEREODEVS):
+		(*val) = gmoss.stereodevs;
+		return (0);
+	}
+	if (SOUND_MIXER_NRDEVICES <= nr ||
+	    0 == (gmoss.devmask & (1 << nr)))
+		return (EINVAL);
+	if (MIXER_READ(nr) == req) {
+		(*val) = dev->vol[nr];
+		return (0);
+	}
+	if (MIXER_WRITE(nr) != req)
+		return (EINVAL);
+	left = MIN(100, MAX(0, ((*val) & 0xff)));
+	right = MIN(100, MAX(0, (((*val) >> 8) & 0xff)));
+	if (0 == (gmoss.stereodevs & (1 << nr))) {
+		right = left;
+	}
+	dev->vol[nr] = (left | (right << 8));
+	dev->modify_counter ++;
+	(*val) = dev->vol[nr];
+
+	return (0);
+}
+
+
+int
+open(const char *path, int flags, ...) {
+	va_list ap;
+	mode_t mode = 0;
+	ssize_t idx = gmoss_path_dev(path);
+
+	if (-1 != idx)
+		return (gmoss_open(idx, flags));
+	if (0 != ((O_CREAT | O_TMPFILE) & flags)) {
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+	pthread_once(&gmoss_once, gmoss_init);
+
+	return (gmoss.open(path, flags, mode));
+}
+
+int
+open64(const char *path, int flags, ...) {
+	va_list ap;
+	mode_t mode = 0;
+	ssize_t idx = gmoss_path_dev(path);
+
+	if (-1 != idx)
+		return (gmoss_open(idx, flags));
+	if (0 != ((O_CREAT | O_TMPFILE) & flags)) {
+		va_start(ap, flags);
+		mode = va_arg(ap, mode_t);
+		va_end(ap);
+	}
+	pthread_once(&gmoss_once, gmoss_init);
+
+	return (gmoss.open64(path, flags, mode));
+}
+
+int
+close(int fd) {
+
+	pthread_once(&gmoss_once, gmoss_init);
+	if (0 <= fd && GMOSS_FDS_MAX > fd) {
+		pthread_mutex_lock(&gmoss_lock);
+		gmoss.fd_dev[fd] = 0;
+		pthread_mutex_unlock(&gmoss_lock);
+	}
+
+	return (gmoss.close(fd));
+}
+
+int
+ioctl(int fd, unsigned long req, ...) {
+	int error;
+	va_list ap;
+	void *arg;
+
+	va_start(ap, req);
+	arg = va_arg(ap, void*);
+	va_end(ap);
+
+	pthread_once(&gmoss_once, gmoss_init);
+	if (0 > fd || GMOSS_FDS_MAX <= fd || 0 == gmoss.fd_dev[fd])
+		return (gmoss.ioctl(fd, req, arg));
+
+	gmoss_latency();
+	pthread_mutex_lock(&gmoss_lock);
+	if (0 == gmoss.fd_dev[fd]) { /* Closed while sleep. */
+		error = EBADF;
+	} else if (NULL == arg) {
+		error = EFAULT;
+	} else {
+		gmoss_events_apply();
+		error = gmoss_ioctl(&gmoss.devs[(gmoss.fd_dev[fd] - 1)],
+		    req, arg);
+	}
+	pthread_mutex_unlock(&gmoss_lock);
+	if (0 != error) {
+		errno = error;
+		return (-1);
+	}
+
+	return (0);
+}
+
+int
+stat(const char *path, struct stat *st) {
+	ssize_t idx = gmoss_path_dev(path);
+
+	pthread_once(&gmoss_once, gmoss_init);
+	if (-1 == idx) {
+		if (NULL == gmoss.stat) {
+			errno = ENOSYS;
+			return (-1);
+		}
+		return (gmoss.stat(path, st));
+	}
+	if (0 > idx) {
+		errno = ENOENT;
+		return (-1);
+	}
+	gmoss_stat_fill((size_t)idx, st);
+
+	return (0);
+}
+
+int
+stat64(const char *path, struct stat64 *st) {
+	ssize_t idx = gmoss_path_dev(path);
+	struct stat st_fake;
+
+	pthread_once(&gmoss_once, gmoss_init);
+	if (-1 == idx) {
+		if (NULL == gmoss.stat64) {
+			errno = ENOSYS;
+			return (-1);
+		}
+		return (gmoss.stat64(path, st));
+	}
+	if (0 > idx) {
+		errno = ENOENT;
+		return (-1);
+	}
+	gmoss_stat_fill((size_t)idx, &st_fake);
+	memset(st, 0x00, sizeof(struct stat64));
+	st->st_dev = st_fake.st_dev;
+	st->st_ino = st_fake.st_ino;
+	st->st_mode = st_fake.st_mode;
+	st->st_nlink = st_fake.st_nlink;
+	st->st_rdev = st_fake.st_rdev;
+	st->st_atim = st_fake.st_atim;
+	st->st_mtim = st_fake.st_mtim;
+	st->st_ctim = st_fake.st_ctim;
+
+	return (0);
+}